@@ -0,0 +1,16 @@
+#ifndef AGC_H
+#define AGC_H
+
+// Automatic gain control (config "agc"): tracks a running high percentile
+// of the bar levels over a time window and returns the gain that puts it
+// near the top of the bar range, so quiet and loud sources both fill the
+// display without hand-tuning sensitivity
+typedef struct agc agc_t;
+
+// Function prototypes
+agc_t *agc_init(float window_s, float db_floor, float db_ceiling);
+float agc_update(agc_t *agc, const float *power, int n, float level_db,
+                 float dt);
+void agc_cleanup(agc_t *agc);
+
+#endif // AGC_H
@@ -3,12 +3,33 @@
 
 #include "config.h"
 
+// Most PipeWire nodes captured at once (comma-separated audio_source)
+#define AUDIO_MAX_SOURCES 16
+
 // Audio context structure
 typedef struct audio_context audio_context_t;
 
+// Source for a context without capture: writes the next block with
+// audio_feed() and returns when it wants to be called again
+// (CLOCK_MONOTONIC ns, 0 at once), or -1 when it is done
+typedef long (*audio_feeder_t)(audio_context_t *ctx, void *arg);
+
 // Function prototypes
-audio_context_t *audio_init(const config_t *config);
-int audio_get_buffer(audio_context_t *ctx, float *buffer, int size);
+audio_context_t *audio_init(const config_t *config, const char *journal_path);
+audio_context_t *audio_init_replay(const char *path, config_t *config);
+audio_context_t *audio_init_feed(const config_t *config, int channels,
+                                 int sources);
+int audio_start_feeder(audio_context_t *ctx, audio_feeder_t feeder,
+                       void *arg);
+void audio_feed(audio_context_t *ctx, int source, const float *samples,
+                int frames);
+int audio_source_count(audio_context_t *ctx);
+const char *audio_source_name(audio_context_t *ctx, int source);
+const float *audio_get_window(audio_context_t *ctx, int source, int size,
+                              const float **fresh_samples, int *fresh);
+long audio_window_time(audio_context_t *ctx, int source);
+long audio_silence_ms(audio_context_t *ctx);
+int audio_wait_for_sound(audio_context_t *ctx, int input_fd);
 void audio_cleanup(audio_context_t *ctx);
 
 #endif // AUDIO_H
@@ -0,0 +1,51 @@
+#ifndef AUDIOVIS_H
+#define AUDIOVIS_H
+
+// libaudiovis: the visualizer's spectrum analysis for embedding in other
+// programs. Create an analyzer from a parameter struct, push mono samples
+// as they arrive and pull the newest spectrum into a buffer you own.
+// Everything is allocated by audiovis_create(); pushing and pulling never
+// allocate, lock or block. The library links FFTW only, not ncurses or
+// PipeWire. One analyzer must not be used from two threads at once.
+
+#define AUDIOVIS_API __attribute__((visibility("default")))
+
+// Analysis engines
+#define AUDIOVIS_ENGINE_AUTO 0 // Cheaper of the two for the parameters
+#define AUDIOVIS_ENGINE_FFT 1
+#define AUDIOVIS_ENGINE_SDFT 2 // Sliding DFT, updated per sample
+#define AUDIOVIS_ENGINE_FIXED 3 // Integer pipeline for weak FPUs
+
+typedef struct {
+  int sample_rate;    // Input sample rate (Hz)
+  int fft_size;       // Analysis window (samples)
+  int bands;          // Spectrum bands, log-spaced from min_freq to max_freq
+  int min_freq;       // Lowest frequency (Hz)
+  int max_freq;       // Highest frequency (Hz)
+  int engine;         // AUDIOVIS_ENGINE_*
+  int update_rate;    // Expected spectra per second (engine choice)
+  float sensitivity;  // Input gain (amplitude multiplier)
+  float bass_boost;   // Gain of the lowest bins
+  float db_floor;     // Level mapped to 0 (dB full scale)
+  float db_ceiling;   // Level mapped to 1 (dB full scale)
+  int attack_ms;      // Rise time constant (0 = instant)
+  int release_ms;     // Fall time constant (0 = instant)
+  int peak_hold_ms;   // Time a peak is held before it falls
+  float gravity;      // Peak fall acceleration, full scales/s^2 (0 = off)
+  int agc;            // Automatic gain control (0/1)
+  int agc_window;     // Seconds of levels the gain control follows
+} audiovis_params_t;
+
+typedef struct audiovis audiovis_t;
+
+// Function prototypes
+AUDIOVIS_API void audiovis_default_params(audiovis_params_t *params);
+AUDIOVIS_API audiovis_t *audiovis_create(const audiovis_params_t *params);
+AUDIOVIS_API void audiovis_push(audiovis_t *av, const float *samples,
+                                int count);
+AUDIOVIS_API int audiovis_spectrum(audiovis_t *av, float *out, int bands,
+                                   float dt);
+AUDIOVIS_API void audiovis_reset(audiovis_t *av);
+AUDIOVIS_API void audiovis_destroy(audiovis_t *av);
+
+#endif // AUDIOVIS_H
@@ -0,0 +1,10 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "config.h"
+
+// Function prototypes
+int batch_run(const char *input, const char *output, const config_t *config,
+              int hop, int threads);
+
+#endif // BATCH_H
@@ -3,7 +3,7 @@
 
 typedef struct {
   // Audio settings
-  char audio_source[256]; // PipeWire source name (or "auto")
+  char audio_source[256]; // PipeWire source(s), comma-separated (or "auto")
   int sample_rate;        // Audio sample rate
   int buffer_size;        // Audio buffer size
 
@@ -17,18 +17,30 @@ typedef struct {
   char color_high[16]; // Color for high frequencies
 
   // Processing settings
-  float sensitivity; // Overall sensitivity multiplier
-  float smoothing;   // Temporal smoothing (0.0-1.0)
+  float sensitivity; // Input gain (amplitude multiplier)
+  int attack_ms;     // Rise time constant (0 = instant)
+  int release_ms;    // Fall time constant (0 = instant)
+  int peak_hold_ms;  // Time a peak is held before it falls
+  float gravity;     // Peak fall acceleration, bar heights/s^2 (0 = off)
   float bass_boost;  // Bass frequency boost
   int min_freq;      // Minimum frequency to visualize
   int max_freq;      // Maximum frequency to visualize
+  int engine;        // 0=auto, 1=fft, 2=sliding dft, 3=fixed point
+  float db_floor;    // Level shown as an empty bar (dB full scale)
+  float db_ceiling;  // Level shown as a full bar (dB full scale)
+  int agc;           // Automatic gain control (0/1)
+  int agc_window;    // Seconds of levels the gain control follows
 
   // Performance settings
-  int fps;         // Target frames per second
-  int sleep_timer; // Sleep when no audio (ms)
+  int fps;            // Target frames per second
+  int analysis_rate;  // Spectra analysed per second (0 = fps)
+  int sleep_timer;    // Sleep when no audio (ms)
+  int backend;        // 0=ncurses, 1=direct ANSI output, 2=headless
+  int render_threads; // Frame composition threads (0 = auto)
+  int governor;       // Lower quality under load (0/1)
 
   // Layout settings
-  int orientation; // 0=vertical, 1=horizontal
+  int orientation; // 0=vertical, 1=horizontal, 2=waterfall
   int reverse;     // Reverse bar direction
   int bar_width;   // Width of each bar in chars
   int bar_spacing; // Spacing between bars
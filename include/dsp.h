@@ -0,0 +1,125 @@
+#ifndef DSP_H
+#define DSP_H
+
+#include <stdint.h>
+#include <string.h>
+
+// 10 * log10(2): converts log2 of a power ratio to decibels
+#define DSP_DB_PER_LOG2 3.01029996f
+
+// Smallest power fed to the log approximation (-300 dB)
+#define DSP_POWER_FLOOR 1e-30f
+
+// log2(1 + t) on [0, 1) as a degree-5 least-squares polynomial;
+// absolute error below 3e-5, inside the 1e-3 dB the DSP check allows
+#define DSP_LOG2_C1 1.44182550f
+#define DSP_LOG2_C2 -0.70867891f
+#define DSP_LOG2_C3 0.41541119f
+#define DSP_LOG2_C4 -0.19440832f
+#define DSP_LOG2_C5 0.04587895f
+
+// Fast log2 for positive normal floats: exponent bits plus a polynomial
+// on the mantissa. SIMD variants compute the same expression lane-wise.
+static inline float dsp_fast_log2(float x) {
+  uint32_t bits;
+  memcpy(&bits, &x, sizeof(bits));
+  float e = (float)((int)(bits >> 23) - 127);
+  bits = (bits & 0x007fffffu) | 0x3f800000u;
+  float m;
+  memcpy(&m, &bits, sizeof(m));
+  float t = m - 1.0f;
+  return e + t * (DSP_LOG2_C1 +
+                  t * (DSP_LOG2_C2 +
+                       t * (DSP_LOG2_C3 + t * (DSP_LOG2_C4 + t * DSP_LOG2_C5))));
+}
+
+// Anti-alias filter limits for decimation ahead of the FFT: taps are a
+// multiple of DSP_TAP_BLOCK (whole vectors), at most DSP_MAX_TAPS, and
+// cost at most DSP_TAP_COST multiply-adds per input sample. The decimated
+// FFT keeps at least DSP_MIN_DECIMATED points.
+#define DSP_TAP_BLOCK 16
+#define DSP_MAX_TAPS 128
+#define DSP_TAP_COST 32
+#define DSP_MIN_DECIMATED 256
+
+// Range of FFT bins averaged into one bar (inclusive)
+typedef struct {
+  int start;
+  int end;
+} dsp_band_t;
+
+// Per-update smoothing parameters (dsp_smooth_params()). Bars rise and
+// fall exponentially with separate time constants; with gravity, a
+// falling bar is held at its peak and then drops with constant
+// acceleration until the smoothed level catches up.
+typedef struct {
+  float attack;       // Weight of the previous level while rising
+  float release;      // Weight of the previous level while falling
+  float hold;         // Seconds a peak is held before it falls
+  float half_gravity; // Half the peak fall acceleration (0 = no peaks)
+  float dt;           // Seconds since the previous update
+} dsp_smooth_t;
+
+// Kernel set compiled for one instruction set
+typedef struct {
+  const char *name;
+  void (*window)(const float *in, const float *window, float *out, int n);
+  void (*power)(const float *bins, const float *gain, float *power, int n);
+  void (*db_scale)(const float *power, float *out, int n, float offset,
+                   float inv_range);
+  void (*smooth)(float *state, float *peak, float *age, float *values,
+                 const dsp_smooth_t *params, int n);
+  void (*downmix)(const float *in, float *out, int frames, int channels);
+  void (*decimate)(const float *in, const float *taps, int num_taps,
+                   int factor, float *out, int n);
+} dsp_kernels_t;
+
+#if defined(__x86_64__) || defined(__i386__)
+extern const dsp_kernels_t dsp_kernels_sse2;
+extern const dsp_kernels_t dsp_kernels_avx2;
+extern const dsp_kernels_t dsp_kernels_avx512;
+#endif
+#if defined(__aarch64__)
+extern const dsp_kernels_t dsp_kernels_neon;
+#endif
+
+// Kernel selection (once at startup; isa overrides autodetection)
+int dsp_init(const char *isa);
+const char *dsp_isa(void);
+int dsp_variant_count(void);
+const dsp_kernels_t *dsp_variant(int index);
+
+// Table setup
+void dsp_hann_table(float *window, int n);
+int dsp_build_bands(dsp_band_t *bands, int bar_count, int sample_rate,
+                    int buffer_size, int min_freq, int max_freq);
+void dsp_bass_gain(float *gain, int num_bins, float bass_boost);
+void dsp_db_params(float scale, float floor_db, float ceiling_db,
+                   float *offset, float *inv_range);
+void dsp_smooth_params(dsp_smooth_t *params, float attack_ms,
+                       float release_ms, float hold_ms, float gravity,
+                       float dt);
+int dsp_decimation(int sample_rate, int buffer_size, int max_freq);
+int dsp_lowpass_taps(int sample_rate, int factor, int max_freq);
+void dsp_lowpass_table(float *taps, int num_taps, int factor);
+
+// Optimized kernels, dispatched to the selected instruction set
+void dsp_window(const float *in, const float *window, float *out, int n);
+void dsp_power(const float *bins, const float *gain, float *power, int n);
+void dsp_bin_bands(const float *power, const dsp_band_t *bands, float *out,
+                   int bar_count);
+void dsp_db_scale(const float *power, float *out, int n, float offset,
+                  float inv_range);
+void dsp_smooth(float *state, float *peak, float *age, float *values,
+                const dsp_smooth_t *params, int n);
+void dsp_downmix(const float *in, float *out, int frames, int channels);
+void dsp_decimate(const float *in, const float *taps, int num_taps,
+                  int factor, float *out, int n);
+
+// Scalar kernels the SIMD variants share
+void dsp_downmix_scalar(const float *in, float *out, int frames,
+                        int channels);
+void dsp_decimate_scalar(const float *in, const float *taps, int num_taps,
+                         int factor, float *out, int n);
+
+#endif // DSP_H
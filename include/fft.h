@@ -3,14 +3,27 @@
 
 #include "config.h"
 
+// Analysis engines (config "engine")
+#define ENGINE_AUTO 0
+#define ENGINE_FFT 1
+#define ENGINE_SDFT 2
+#define ENGINE_FIXED 3
+
 // FFT context structure
 typedef struct fft_context fft_context_t;
 
 // Function prototypes
 fft_context_t *fft_init(int sample_rate, int buffer_size,
                         const config_t *config);
+fft_context_t *fft_init_estimate(int sample_rate, int buffer_size,
+                                 const config_t *config);
+void fft_wait_plan(fft_context_t *ctx);
+void fft_push(fft_context_t *ctx, const float *samples, int count);
 void fft_process(fft_context_t *ctx, const float *audio_buffer,
                  float *magnitudes, int bar_count);
+void fft_process_dt(fft_context_t *ctx, const float *audio_buffer,
+                    float *magnitudes, int bar_count, float dt);
+void fft_reset(fft_context_t *ctx);
 void fft_cleanup(fft_context_t *ctx);
 
 #endif // FFT_H
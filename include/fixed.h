@@ -0,0 +1,18 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include "config.h"
+
+// Fixed-point analysis engine (engine = 3) for CPUs with weak or no
+// floating point: Q15 samples and window, a Q31 real FFT, integer
+// magnitudes and integer band sums. Only the per-bar result is float.
+typedef struct fixed_context fixed_context_t;
+
+// Function prototypes
+fixed_context_t *fixed_init(int sample_rate, int buffer_size,
+                            const config_t *config);
+void fixed_process(fixed_context_t *ctx, const float *samples, float *bands,
+                   int bar_count);
+void fixed_cleanup(fixed_context_t *ctx);
+
+#endif // FIXED_H
@@ -0,0 +1,30 @@
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include "config.h"
+
+// Quality ladder: each level keeps the savings of the levels above it
+#define QUALITY_FULL 0
+#define QUALITY_SOLID 1      // Solid-color bars instead of gradients
+#define QUALITY_HALF_RATE 2  // Half the frame and analysis rates
+#define QUALITY_HALF_BARS 3  // Half the bars
+#define QUALITY_SMALL_FFT 4  // Half the FFT size; the engine is re-chosen
+#define QUALITY_LEVELS 5
+
+// Adaptive quality governor: watches how much of the wall-clock time the
+// analysis and drawing take and steps quality down under load and back
+// up once it has passed, with hysteresis against flapping
+typedef struct governor governor_t;
+
+// Function prototypes
+governor_t *governor_init(int max_level, long now_ns);
+void governor_add(governor_t *gov, long busy_ns);
+int governor_update(governor_t *gov, long now_ns);
+void governor_reset(governor_t *gov, long now_ns);
+int governor_level(const governor_t *gov);
+const char *governor_level_name(int level);
+void governor_apply(int level, const config_t *base, config_t *active);
+void governor_report(const governor_t *gov, long now_ns);
+void governor_cleanup(governor_t *gov);
+
+#endif // GOVERNOR_H
@@ -0,0 +1,34 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+// Capture journal (--journal FILE): every buffer PipeWire delivers, with
+// its raw samples, size and timing, for faithful replay
+// (--journal-replay FILE)
+typedef struct journal journal_t;
+typedef struct journal_reader journal_reader_t;
+
+// One journalled buffer. Times are CLOCK_MONOTONIC when written and
+// relative to the start of the journal when read back.
+typedef struct {
+  int source;
+  int channels;
+  int frames;         // 0 for a callback without data
+  int chunk_size;     // Bytes PipeWire reported for the chunk
+  long arrival_ns;    // When on_process() ran
+  long captured_ns;   // Capture time of the newest sample
+  int dropped;        // Buffers of its source lost before it (read back)
+  const float *samples; // Interleaved; valid until the next journal_read()
+} journal_block_t;
+
+// Function prototypes
+journal_t *journal_open(const char *path, int sample_rate, int channels,
+                        int sources, long start_ns);
+void journal_block(journal_t *journal, const journal_block_t *block);
+void journal_close(journal_t *journal);
+
+journal_reader_t *journal_reader_open(const char *path, int *sample_rate,
+                                      int *channels, int *sources);
+int journal_read(journal_reader_t *reader, journal_block_t *block);
+void journal_reader_close(journal_reader_t *reader);
+
+#endif // JOURNAL_H
@@ -0,0 +1,17 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stddef.h>
+
+// Capture-to-display latency statistics (--latency): the age of the
+// newest sample on screen at the moment each frame was flushed
+typedef struct latency latency_t;
+
+// Function prototypes
+latency_t *latency_init(long now_ns);
+int latency_add(latency_t *lat, long age_ns, long now_ns);
+void latency_format(const latency_t *lat, char *buf, size_t size);
+void latency_report(const latency_t *lat);
+void latency_cleanup(latency_t *lat);
+
+#endif // LATENCY_H
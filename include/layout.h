@@ -0,0 +1,71 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include "config.h"
+#include "pool.h"
+
+// Color pairs shared by all render backends (0 = terminal default)
+#define COLOR_PAIR_LOW 1
+#define COLOR_PAIR_MID 2
+#define COLOR_PAIR_HIGH 3
+
+// Glyphs a backend draws; the value is also the waterfall shade level
+#define GLYPH_SPACE 0
+#define GLYPH_LIGHT 1
+#define GLYPH_MEDIUM 2
+#define GLYPH_DARK 3
+#define GLYPH_BAR 4 // config bar_char
+#define WATERFALL_SHADES 5
+
+// Text attributes
+#define TEXT_DIM 1
+#define TEXT_BOLD 2
+
+// Screens of at least this many cells are composed across the canvas
+// pool; on smaller ones waking the workers costs more than it saves
+#define LAYOUT_PARALLEL_CELLS 16384
+
+// Drawing target: a backend supplies the cell and text primitives, and
+// the layout code draws bars, waterfall rows and panels through them
+typedef struct canvas canvas_t;
+struct canvas {
+  void (*put)(canvas_t *canvas, int y, int x, int glyph, int color);
+  void (*text)(canvas_t *canvas, int y, int x, const char *s, int max_len,
+               int attr);
+  void *data;
+
+  // Workers for large frames, set by backends whose put and text may run
+  // on several threads at once for disjoint cells (NULL for ncurses)
+  worker_pool_t *pool;
+
+  // Current drawing area in screen coordinates; its last line holds the
+  // controls hint or the panel label
+  int y;
+  int x;
+  int height;
+  int width;
+};
+
+// UTF-8 of the shade glyphs (GLYPH_SPACE to GLYPH_DARK)
+extern const char *const layout_shade_chars[GLYPH_BAR];
+
+// Function prototypes
+int layout_color_code(const char *color_name);
+int layout_color_for_height(float height, int gradient_mode);
+int layout_bars(int bar_count, int width, const config_t *config,
+                int *start_x);
+int layout_shade(float magnitude);
+void layout_set_status(const char *status);
+const char *layout_hint(void);
+void layout_set_area(canvas_t *canvas, int y, int x, int height, int width);
+void layout_draw_bars(canvas_t *canvas, const float *magnitudes,
+                      int bar_count, const config_t *config);
+void layout_draw_waterfall_row(canvas_t *canvas, int y,
+                               const unsigned char *levels, int bars,
+                               int start_x, const config_t *config);
+void layout_draw_panels(canvas_t *canvas, const float *const *magnitudes,
+                        const char *const *labels, int panels, int bar_count,
+                        int screen_height, int screen_width,
+                        const config_t *config);
+
+#endif // LAYOUT_H
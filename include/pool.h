@@ -0,0 +1,14 @@
+#ifndef POOL_H
+#define POOL_H
+
+// Fork-join worker pool: pool_run() spreads task indices over the workers
+// and the calling thread, and returns once every task has finished
+typedef struct worker_pool worker_pool_t;
+typedef void (*pool_task_fn)(void *arg, int index);
+
+// Function prototypes
+worker_pool_t *pool_init(int threads);
+void pool_run(worker_pool_t *pool, pool_task_fn fn, void *arg, int count);
+void pool_cleanup(worker_pool_t *pool);
+
+#endif // POOL_H
@@ -0,0 +1,21 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include "config.h"
+
+// Spectrum recording/replay handles
+typedef struct recorder recorder_t;
+typedef struct replayer replayer_t;
+
+// Function prototypes
+recorder_t *record_open(const char *filename, const config_t *config);
+int record_frame(recorder_t *rec, const float *magnitudes, int bar_count,
+                 long timestamp_ns);
+void record_close(recorder_t *rec);
+
+replayer_t *replay_open(const char *filename, config_t *config);
+int replay_frame(replayer_t *rp, float *magnitudes, int bar_count,
+                 long *timestamp_ns);
+void replay_close(replayer_t *rp);
+
+#endif // RECORD_H
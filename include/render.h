@@ -3,10 +3,21 @@
 
 #include "config.h"
 
+// Render backends (config "backend")
+#define BACKEND_NCURSES 0
+#define BACKEND_ANSI 1
+#define BACKEND_HEADLESS 2
+
 // Function prototypes
 int render_init(const config_t *config);
 void render_frame(const float *magnitudes, int bar_count,
                   const config_t *config);
+void render_panels(const float *const *magnitudes, const char *const *labels,
+                   int panels, int bar_count, const config_t *config);
+void render_status(const char *status);
+int render_getch(void);
+int render_input_fd(void);
+int render_dump(const char *path, const config_t *config);
 void render_cleanup(void);
 
 #endif // RENDER_H
@@ -0,0 +1,16 @@
+#ifndef RENDER_ANSI_H
+#define RENDER_ANSI_H
+
+#include "config.h"
+#include "pool.h"
+
+// Direct ANSI terminal backend, selected through render_init()
+int ansi_init(const config_t *config, worker_pool_t *workers);
+void ansi_frame(const float *magnitudes, int bar_count,
+                const config_t *config);
+void ansi_panels(const float *const *magnitudes, const char *const *labels,
+                 int panels, int bar_count, const config_t *config);
+int ansi_getch(void);
+void ansi_cleanup(void);
+
+#endif // RENDER_ANSI_H
@@ -0,0 +1,20 @@
+#ifndef RENDER_HEADLESS_H
+#define RENDER_HEADLESS_H
+
+#include "config.h"
+#include "pool.h"
+#include <stdio.h>
+
+// In-memory backend: draws through the shared layout code into a cell
+// grid (glyph and color per cell) without a terminal, for benchmarks and
+// golden tests. The grid is $COLUMNS x $LINES (default 80x24).
+int headless_init(const config_t *config, worker_pool_t *workers);
+void headless_frame(const float *magnitudes, int bar_count,
+                    const config_t *config);
+void headless_panels(const float *const *magnitudes,
+                     const char *const *labels, int panels, int bar_count,
+                     const config_t *config);
+int headless_dump(FILE *file, const config_t *config);
+void headless_cleanup(void);
+
+#endif // RENDER_HEADLESS_H
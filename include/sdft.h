@@ -0,0 +1,17 @@
+#ifndef SDFT_H
+#define SDFT_H
+
+#include "config.h"
+
+// Sliding DFT context structure
+typedef struct sdft_context sdft_context_t;
+
+// Function prototypes
+sdft_context_t *sdft_init(int sample_rate, int buffer_size,
+                          const config_t *config);
+void sdft_push(sdft_context_t *ctx, const float *samples, int count);
+void sdft_read(sdft_context_t *ctx, float *bands, int bar_count);
+float sdft_cost(int bar_count, int hop);
+void sdft_cleanup(sdft_context_t *ctx);
+
+#endif // SDFT_H
@@ -0,0 +1,25 @@
+#ifndef SOAK_H
+#define SOAK_H
+
+#include "audio.h"
+#include "config.h"
+
+// Soak test (--soak SECONDS): the main loop runs as usual, governor,
+// interpolation, worker pool and idle wait included, on a synthetic
+// signal or a looped capture journal, but at full speed: audio is fed as
+// fast as it is written and frames never wait for their deadlines, so a
+// run covers far more playing time than it lasts. Memory, file
+// descriptors, threads and frame time are sampled along the way, and the
+// run fails with a report if any of them drifts.
+typedef struct soak soak_t;
+
+// Function prototypes
+soak_t *soak_init(config_t *config, const char *journal_path, int seconds);
+audio_context_t *soak_audio(soak_t *soak, const config_t *config);
+int soak_sample_due(const soak_t *soak, long now);
+int soak_frame(soak_t *soak, long frame_ns, long now);
+void soak_stop(soak_t *soak, long now);
+int soak_report(const soak_t *soak);
+void soak_cleanup(soak_t *soak);
+
+#endif // SOAK_H
@@ -0,0 +1,18 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Span tracing for offline profiling (--trace FILE). Spans from any
+// thread, including the PipeWire callback, go into a preallocated ring
+// without locks or allocation; trace_close() writes them as Chrome
+// trace-event JSON (chrome://tracing, ui.perfetto.dev). Span names must
+// be string literals. While tracing is off, trace_begin() returns 0 and
+// trace_end() does nothing.
+
+// Function prototypes
+int trace_open(const char *path);
+void trace_thread_name(const char *name);
+long trace_begin(void);
+void trace_end(const char *name, long start_ns);
+void trace_close(void);
+
+#endif // TRACE_H
@@ -5,5 +5,6 @@
 void trim_whitespace(char *str);
 int parse_bool(const char *str);
 float clamp(float value, float min, float max);
+long now_ns(void);
 
 #endif // UTILS_H
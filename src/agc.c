@@ -0,0 +1,124 @@
+#include "agc.h"
+#include "dsp.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Tracked percentile of the bar levels, and where in the bar range it is
+// placed (0 = db_floor, 1 = db_ceiling)
+#define PERCENTILE 0.95
+#define TARGET 0.9f
+
+// Level histogram in 0.5 dB bins from -120 to +40 dB full scale
+#define BIN_DB 0.5f
+#define MIN_DB -120.0f
+#define BINS 320
+
+// Bars below this level (digital silence, dither) do not count
+#define GATE_DB -100.0f
+
+// Gain limits, and glide time constants: the gain drops quickly when
+// the level rises so bars do not clip for long, and rises slowly
+#define MIN_GAIN_DB -40.0f
+#define MAX_GAIN_DB 60.0f
+#define DROP_MS 100.0f
+#define RISE_MS 1000.0f
+
+// Weights grow instead of the histogram decaying; everything is scaled
+// back down once they get this large
+#define RESCALE_WEIGHT 1e30
+
+// Decaying histogram: a level added t seconds ago counts exp(-t / window).
+// Rather than decaying every bin each frame, new levels are added with a
+// weight that grows by exp(dt / window). The percentile bin is kept with
+// the weight above it and only moves as far as the levels do, so an
+// update costs O(1) per bar plus the distance the percentile moved.
+struct agc {
+  double histogram[BINS];
+  double total;  // Weight of all bins
+  double above;  // Weight of the bins above the percentile bin
+  double weight; // Weight of a level added now
+  int bin;       // Percentile bin
+
+  float window_s;
+  float target_db;
+  float gain_db;
+};
+
+agc_t *agc_init(float window_s, float db_floor, float db_ceiling) {
+  agc_t *agc = calloc(1, sizeof(agc_t));
+  if (!agc) {
+    fprintf(stderr, "Failed to allocate gain control\n");
+    return NULL;
+  }
+
+  agc->weight = 1.0;
+  agc->window_s = window_s > 0.1f ? window_s : 0.1f;
+  agc->target_db = db_floor + TARGET * (db_ceiling - db_floor);
+  return agc;
+}
+
+// Move the percentile bin until the weight above it is just within the
+// top (1 - PERCENTILE) share
+static void track(agc_t *agc) {
+  double limit = (1.0 - PERCENTILE) * agc->total;
+
+  while (agc->above > limit && agc->bin < BINS - 1) {
+    agc->bin++;
+    agc->above -= agc->histogram[agc->bin];
+  }
+  while (agc->bin > 0 && agc->above + agc->histogram[agc->bin] <= limit) {
+    agc->above += agc->histogram[agc->bin];
+    agc->bin--;
+  }
+}
+
+// Add one analysis worth of bar power (level_db is the level of power 1,
+// sensitivity included) and return the gain in dB to apply to it, dt
+// seconds after the previous update
+float agc_update(agc_t *agc, const float *power, int n, float level_db,
+                 float dt) {
+  if (!agc)
+    return 0.0f;
+
+  agc->weight *= exp(dt / agc->window_s);
+  if (agc->weight > RESCALE_WEIGHT) {
+    double scale = 1.0 / agc->weight;
+    for (int i = 0; i < BINS; i++)
+      agc->histogram[i] *= scale;
+    agc->total *= scale;
+    agc->above *= scale;
+    agc->weight = 1.0;
+  }
+
+  for (int i = 0; i < n; i++) {
+    float p = power[i] > DSP_POWER_FLOOR ? power[i] : DSP_POWER_FLOOR;
+    float db = DSP_DB_PER_LOG2 * dsp_fast_log2(p) + level_db;
+    if (db < GATE_DB)
+      continue;
+
+    int bin = (int)((db - MIN_DB) / BIN_DB);
+    bin = bin < 0 ? 0 : (bin >= BINS ? BINS - 1 : bin);
+    agc->histogram[bin] += agc->weight;
+    agc->total += agc->weight;
+    if (bin > agc->bin)
+      agc->above += agc->weight;
+  }
+
+  // Nothing above the gate yet: keep the current gain
+  if (agc->total <= 0.0)
+    return agc->gain_db;
+  track(agc);
+
+  float level = MIN_DB + (agc->bin + 0.5f) * BIN_DB;
+  float want = agc->target_db - level;
+  want = want < MIN_GAIN_DB ? MIN_GAIN_DB
+                            : (want > MAX_GAIN_DB ? MAX_GAIN_DB : want);
+
+  float tau_ms = want < agc->gain_db ? DROP_MS : RISE_MS;
+  float keep = expf(-dt * 1000.0f / tau_ms);
+  agc->gain_db = want + (agc->gain_db - want) * keep;
+  return agc->gain_db;
+}
+
+void agc_cleanup(agc_t *agc) { free(agc); }
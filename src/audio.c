@@ -1,65 +1,363 @@
+#define _GNU_SOURCE // memfd_create()
 #include "audio.h"
+#include "dsp.h"
+#include "journal.h"
+#include "trace.h"
+#include "utils.h"
 #include <pipewire/pipewire.h>
+#include <poll.h>
 #include <pthread.h>
 #include <spa/param/audio/format-utils.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+// Capture ring in samples (power of two, whole pages). Analysis windows
+// are read in place without the lock, so the ring is much larger than
+// the biggest window: a window is only overwritten if capture runs
+// RING_BUFFER_SIZE - MAX_WINDOW samples (over a second) ahead of a frame.
+#define RING_BUFFER_SIZE 65536
+#define MAX_WINDOW 16384
+#define MIX_CHUNK 1024
+
+// Longest single sleep of the journal replay thread
+#define REPLAY_SLICE_NS 100000000L
+
+// Mean square below this (about -80 dBFS) counts as silence
+#define SILENCE_THRESHOLD 1e-8f
+
+// One captured PipeWire node
+typedef struct {
+  audio_context_t *ctx;
+  struct pw_stream *stream;
+  char name[64]; // target.object (node name or serial), or "auto"
+
+  // Ring of mono samples followed by a mirror of itself, so
+  // ring[i + RING_BUFFER_SIZE] == ring[i] and any window up to
+  // RING_BUFFER_SIZE samples is contiguous. With a double-mapped memfd the
+  // mirror is the same physical pages; otherwise every write is duplicated.
+  float *ring;
+  int mirrored;
+  float mix_buffer[MIX_CHUNK];
+  int write_pos;
+  long written;   // Total samples captured (protected by mutex)
+  long read_mark; // Value of written at the last audio_get_window()
 
-#define RING_BUFFER_SIZE 8192
+  // Capture time (CLOCK_MONOTONIC) of the newest sample in the ring
+  // (protected by mutex), and of the newest sample in the last window
+  long captured_ns;
+  long window_ns;
+} audio_source_t;
 
 // Audio context structure
 struct audio_context {
   struct pw_main_loop *loop;
-  struct pw_stream *stream;
   struct pw_thread_loop *thread_loop;
 
-  float ring_buffer[RING_BUFFER_SIZE];
-  int write_pos;
-  int read_pos;
+  // All sources share the thread loop and the mutex
+  audio_source_t sources[AUDIO_MAX_SOURCES];
+  int num_sources;
   pthread_mutex_t mutex;
 
+  // Silence tracking across all sources (protected by mutex)
+  long last_sound_ns; // Last block above SILENCE_THRESHOLD
+  int idle;           // Main thread is blocked in audio_wait_for_sound()
+  int wake_fd;        // eventfd signalled when sound resumes while idle
+
   int sample_rate;
   int channels;
+  int pipewire; // pw_init() was called
+
+  // Capture journal being written, or journal being replayed
+  // instead of capturing
+  journal_t *journal;
+  journal_reader_t *replay;
+
+  // Thread feeding the rings instead of capture: the journal replay or an
+  // audio_start_feeder() source
+  audio_feeder_t feeder;
+  void *feeder_arg;
+  pthread_t feed_thread;
+  int feed_started;
+  int feed_stop; // atomic
 };
 
+// Map one memfd twice back-to-back; NULL if that is not supported
+static float *map_mirrored_ring(size_t bytes) {
+  int fd = memfd_create("audiovis-ring", MFD_CLOEXEC);
+  if (fd < 0)
+    return NULL;
+
+  if (ftruncate(fd, bytes) != 0) {
+    close(fd);
+    return NULL;
+  }
+
+  // Reserve the whole range first so both halves land next to each other
+  uint8_t *base =
+      mmap(NULL, 2 * bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED) {
+    close(fd);
+    return NULL;
+  }
+
+  if (mmap(base, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd,
+           0) == MAP_FAILED ||
+      mmap(base + bytes, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+           fd, 0) == MAP_FAILED) {
+    munmap(base, 2 * bytes);
+    close(fd);
+    return NULL;
+  }
+
+  // The mappings keep the memory alive
+  close(fd);
+  return (float *)base;
+}
+
+// Copy mono samples into both halves of a ring without the double mapping
+static void ring_write_copy(audio_source_t *src, const float *mono,
+                            int frames) {
+  int first = RING_BUFFER_SIZE - src->write_pos;
+  if (first > frames)
+    first = frames;
+
+  float *dst = src->ring + src->write_pos;
+  memcpy(dst, mono, first * sizeof(float));
+  memcpy(dst + RING_BUFFER_SIZE, mono, first * sizeof(float));
+  memcpy(src->ring, mono + first, (frames - first) * sizeof(float));
+  memcpy(src->ring + RING_BUFFER_SIZE, mono + first,
+         (frames - first) * sizeof(float));
+}
+
+// Both ring variants start zeroed, so early windows read as silence
+static int alloc_ring(audio_source_t *src) {
+  src->ring = map_mirrored_ring(RING_BUFFER_SIZE * sizeof(float));
+  src->mirrored = src->ring != NULL;
+  if (!src->ring)
+    src->ring = calloc(2 * RING_BUFFER_SIZE, sizeof(float));
+  return src->ring != NULL;
+}
+
+static void free_ring(audio_source_t *src) {
+  if (src->mirrored)
+    munmap(src->ring, 2 * RING_BUFFER_SIZE * sizeof(float));
+  else
+    free(src->ring);
+}
+
+// Capture time of the newest sample of the block being processed: the
+// graph cycle time minus the delay from the device and the samples still
+// buffered in the stream, or now if the stream has no timing yet
+static long block_time(audio_source_t *src, int sample_rate) {
+  struct pw_time t;
+  if (pw_stream_get_time_n(src->stream, &t, sizeof(t)) != 0 || t.now == 0 ||
+      t.rate.denom == 0)
+    return now_ns();
+
+  long delay_ns = (long)((double)t.delay * t.rate.num * 1e9 / t.rate.denom);
+  if (sample_rate > 0)
+    delay_ns += (long)((double)t.buffered * 1e9 / sample_rate);
+  return t.now - delay_ns;
+}
+
+// Downmix one block of interleaved samples into a source's ring
+static void write_block(audio_source_t *src, const float *samples,
+                        uint32_t n_frames, long captured_ns) {
+  audio_context_t *ctx = src->ctx;
+
+  // Write to ring buffer
+  int loud = 0;
+  pthread_mutex_lock(&ctx->mutex);
+  for (uint32_t done = 0; done < n_frames;) {
+    // Mix all channels to mono, a chunk at a time; a mirrored ring takes
+    // the chunk in place even when it crosses the end
+    int frames = n_frames - done;
+    if (frames > MIX_CHUNK)
+      frames = MIX_CHUNK;
+    float *mono = src->mirrored ? src->ring + src->write_pos : src->mix_buffer;
+    dsp_downmix(samples + done * ctx->channels, mono, frames, ctx->channels);
+
+    // Cheap energy check for idle detection
+    if (!loud) {
+      float energy = 0.0f;
+      for (int i = 0; i < frames; i++)
+        energy += mono[i] * mono[i];
+      loud = energy > SILENCE_THRESHOLD * frames;
+    }
+
+    if (!src->mirrored)
+      ring_write_copy(src, mono, frames);
+    src->write_pos = (src->write_pos + frames) & (RING_BUFFER_SIZE - 1);
+    src->written += frames;
+
+    done += frames;
+  }
+  src->captured_ns = captured_ns;
+
+  if (loud) {
+    ctx->last_sound_ns = now_ns();
+    if (ctx->idle) {
+      uint64_t one = 1;
+      ctx->idle = 0;
+      if (write(ctx->wake_fd, &one, sizeof(one)) < 0) {
+        // Nothing useful to do from the RT thread; the waiter keeps polling
+      }
+    }
+  }
+  pthread_mutex_unlock(&ctx->mutex);
+}
+
 // Callback when audio data is available
 static void on_process(void *userdata) {
-  audio_context_t *ctx = (audio_context_t *)userdata;
+  audio_source_t *src = (audio_source_t *)userdata;
+  audio_context_t *ctx = src->ctx;
   struct pw_buffer *b;
   struct spa_buffer *buf;
-  float *samples;
-  uint32_t n_samples;
-
-  if ((b = pw_stream_dequeue_buffer(ctx->stream)) == NULL) {
+  journal_t *journal = ctx->journal;
+  journal_block_t entry = {.source = src - ctx->sources,
+                           .channels = ctx->channels};
+
+  trace_thread_name("pipewire");
+  long trace_start = trace_begin();
+  if (journal)
+    entry.arrival_ns = now_ns();
+
+  if ((b = pw_stream_dequeue_buffer(src->stream)) == NULL) {
+    // Journal the empty callback too: it is part of the timing
+    if (journal) {
+      entry.captured_ns = entry.arrival_ns;
+      journal_block(journal, &entry);
+    }
+    trace_end("on_process", trace_start);
     return;
   }
 
   buf = b->buffer;
-  if (buf->datas[0].data == NULL) {
-    goto done;
+  if (buf->datas[0].data != NULL) {
+    const float *samples = (const float *)buf->datas[0].data;
+    uint32_t n_samples = buf->datas[0].chunk->size / sizeof(float);
+    uint32_t n_frames = n_samples / ctx->channels;
+    long captured_ns = block_time(src, ctx->sample_rate);
+
+    write_block(src, samples, n_frames, captured_ns);
+
+    entry.frames = n_frames;
+    entry.chunk_size = buf->datas[0].chunk->size;
+    entry.samples = samples;
+    entry.captured_ns = captured_ns;
+  } else {
+    entry.captured_ns = entry.arrival_ns;
   }
 
-  samples = (float *)buf->datas[0].data;
-  n_samples = buf->datas[0].chunk->size / sizeof(float);
+  journal_block(journal, &entry);
+  pw_stream_queue_buffer(src->stream, b);
+  trace_end("on_process", trace_start);
+}
 
-  // Write to ring buffer
-  pthread_mutex_lock(&ctx->mutex);
-  for (uint32_t i = 0; i < n_samples; i += ctx->channels) {
-    // Mix all channels to mono
-    float sample = 0.0f;
-    for (int ch = 0; ch < ctx->channels && ch < 2; ch++) {
-      sample += samples[i + ch];
+// Write frames of silence (at most a ring's worth) into a source ring
+static void write_silence(audio_source_t *src, const float *zeros,
+                          long frames, long captured_ns) {
+  if (frames > RING_BUFFER_SIZE)
+    frames = RING_BUFFER_SIZE;
+  for (long done = 0; done < frames; done += MIX_CHUNK) {
+    long n = frames - done < MIX_CHUNK ? frames - done : MIX_CHUNK;
+    write_block(src, zeros, n, captured_ns);
+  }
+}
+
+// Sleep until due_ns in slices, so cleanup is not held up by a long
+// pause; returns 0 if the feeding thread was asked to stop
+static int sleep_until(audio_context_t *ctx, long due_ns) {
+  while (now_ns() < due_ns &&
+         !__atomic_load_n(&ctx->feed_stop, __ATOMIC_ACQUIRE)) {
+    long wake_ns = now_ns() + REPLAY_SLICE_NS;
+    if (wake_ns > due_ns)
+      wake_ns = due_ns;
+    struct timespec wake = {.tv_sec = wake_ns / 1000000000L,
+                            .tv_nsec = wake_ns % 1000000000L};
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL);
+  }
+  return !__atomic_load_n(&ctx->feed_stop, __ATOMIC_ACQUIRE);
+}
+
+// Replay thread: feed journalled buffers into the rings at their original
+// arrival times (shifted to now), then stop; the sources go silent.
+// Buffers the journal dropped are replayed as silence spanning the
+// capture time they covered, so later samples stay in place.
+static void *replay_main(void *data) {
+  audio_context_t *ctx = data;
+  journal_block_t entry;
+  long start_ns = now_ns();
+  long last_captured_ns[AUDIO_MAX_SOURCES];
+  int after_gap[AUDIO_MAX_SOURCES] = {0};
+  float *zeros = calloc((size_t)MIX_CHUNK * ctx->channels, sizeof(float));
+
+  for (int i = 0; i < AUDIO_MAX_SOURCES; i++)
+    last_captured_ns[i] = -1;
+
+  trace_thread_name("journal replay");
+  while (!__atomic_load_n(&ctx->feed_stop, __ATOMIC_ACQUIRE)) {
+    int status = journal_read(ctx->replay, &entry);
+    if (status <= 0) {
+      if (status < 0)
+        fprintf(stderr, "Journal damaged, replay stopped\n");
+      break;
+    }
+
+    if (!sleep_until(ctx, start_ns + entry.arrival_ns))
+      break;
+
+    if (entry.source < 0 || entry.source >= ctx->num_sources)
+      continue;
+    if (entry.dropped > 0) {
+      fprintf(stderr, "Journal gap: %d buffers of source %d dropped while "
+                      "recording, replayed as silence\n",
+              entry.dropped, entry.source);
+      after_gap[entry.source] = 1;
+    }
+    if (entry.channels != ctx->channels || entry.frames == 0)
+      continue;
+
+    long trace_start = trace_begin();
+    audio_source_t *src = &ctx->sources[entry.source];
+    long *last_ns = &last_captured_ns[entry.source];
+    if (after_gap[entry.source] && *last_ns >= 0 && zeros) {
+      // Frames between the previous buffer and this one that never arrived
+      long missing = (entry.captured_ns - *last_ns) * ctx->sample_rate /
+                         1000000000L -
+                     entry.frames;
+      if (missing > 0)
+        write_silence(src, zeros, missing,
+                      start_ns + entry.captured_ns -
+                          entry.frames * 1000000000L / ctx->sample_rate);
     }
-    sample /= ctx->channels;
+    after_gap[entry.source] = 0;
+    *last_ns = entry.captured_ns;
 
-    ctx->ring_buffer[ctx->write_pos] = sample;
-    ctx->write_pos = (ctx->write_pos + 1) % RING_BUFFER_SIZE;
+    write_block(src, entry.samples, entry.frames,
+                start_ns + entry.captured_ns);
+    trace_end("journal_replay", trace_start);
   }
-  pthread_mutex_unlock(&ctx->mutex);
 
-done:
-  pw_stream_queue_buffer(ctx->stream, b);
+  free(zeros);
+  return NULL;
+}
+
+// Feeder thread: call the feeder whenever it asked to be called next
+static void *feeder_main(void *data) {
+  audio_context_t *ctx = data;
+  long due_ns = now_ns();
+
+  trace_thread_name("audio feeder");
+  while (due_ns >= 0 && sleep_until(ctx, due_ns))
+    due_ns = ctx->feeder(ctx, ctx->feeder_arg);
+  return NULL;
 }
 
 // Stream events
@@ -68,8 +366,84 @@ static const struct pw_stream_events stream_events = {
     .process = on_process,
 };
 
-// Initialize PipeWire audio capture
-audio_context_t *audio_init(const config_t *config) {
+// Split the comma-separated source list; an empty list means "auto"
+static void parse_sources(audio_context_t *ctx, const char *list) {
+  char buffer[sizeof(((config_t *)0)->audio_source)];
+  strncpy(buffer, list, sizeof(buffer) - 1);
+  buffer[sizeof(buffer) - 1] = '\0';
+
+  char *saveptr = NULL;
+  for (char *token = strtok_r(buffer, ",", &saveptr); token;
+       token = strtok_r(NULL, ",", &saveptr)) {
+    trim_whitespace(token);
+    if (*token == '\0')
+      continue;
+    if (ctx->num_sources == AUDIO_MAX_SOURCES) {
+      fprintf(stderr, "Only the first %d audio sources are captured\n",
+              AUDIO_MAX_SOURCES);
+      break;
+    }
+
+    audio_source_t *src = &ctx->sources[ctx->num_sources++];
+    strncpy(src->name, token, sizeof(src->name) - 1);
+    src->name[sizeof(src->name) - 1] = '\0';
+  }
+
+  if (ctx->num_sources == 0) {
+    strcpy(ctx->sources[0].name, "auto");
+    ctx->num_sources = 1;
+  }
+}
+
+// Create and connect one capture stream (thread loop must be locked)
+static int connect_source(audio_context_t *ctx, audio_source_t *src,
+                          struct pw_loop *loop) {
+  struct pw_properties *props =
+      pw_properties_new(PW_KEY_MEDIA_TYPE, "Audio", PW_KEY_MEDIA_CATEGORY,
+                        "Capture", PW_KEY_MEDIA_ROLE, "Music", NULL);
+  if (strcmp(src->name, "auto") != 0)
+    pw_properties_set(props, PW_KEY_TARGET_OBJECT, src->name);
+
+  src->stream = pw_stream_new_simple(loop, "audiovis-capture", props,
+                                     &stream_events, src);
+  if (!src->stream) {
+    fprintf(stderr, "Failed to create PipeWire stream for '%s'\n", src->name);
+    return -1;
+  }
+
+  // Audio format parameters
+  uint8_t buffer[1024];
+  struct spa_pod_builder b = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
+
+  const struct spa_pod *params[1];
+  params[0] = spa_format_audio_raw_build(
+      &b, SPA_PARAM_EnumFormat,
+      &SPA_AUDIO_INFO_RAW_INIT(.format = SPA_AUDIO_FORMAT_F32,
+                               .channels = ctx->channels,
+                               .rate = ctx->sample_rate));
+
+  int ret = pw_stream_connect(src->stream, PW_DIRECTION_INPUT, PW_ID_ANY,
+                              PW_STREAM_FLAG_AUTOCONNECT |
+                                  PW_STREAM_FLAG_MAP_BUFFERS |
+                                  PW_STREAM_FLAG_RT_PROCESS,
+                              params, 1);
+  if (ret < 0) {
+    fprintf(stderr, "Failed to connect stream for '%s': error code %d\n",
+            src->name, ret);
+    return -1;
+  }
+
+  return 0;
+}
+
+// Context without a capture backend yet
+static audio_context_t *context_new(const config_t *config) {
+  if (config->buffer_size > MAX_WINDOW) {
+    fprintf(stderr, "Buffer size %d exceeds the capture window limit (%d)\n",
+            config->buffer_size, MAX_WINDOW);
+    return NULL;
+  }
+
   audio_context_t *ctx = calloc(1, sizeof(audio_context_t));
   if (!ctx) {
     fprintf(stderr, "Failed to allocate audio context\n");
@@ -78,100 +452,279 @@ audio_context_t *audio_init(const config_t *config) {
 
   ctx->sample_rate = config->sample_rate;
   ctx->channels = 2; // Stereo
-  ctx->write_pos = 0;
-  ctx->read_pos = 0;
+  ctx->last_sound_ns = now_ns();
+  ctx->wake_fd = -1;
   pthread_mutex_init(&ctx->mutex, NULL);
+  return ctx;
+}
+
+// Rings for every source and the idle wake-up eventfd
+static int context_buffers(audio_context_t *ctx) {
+  for (int i = 0; i < ctx->num_sources; i++) {
+    ctx->sources[i].ctx = ctx;
+    if (!alloc_ring(&ctx->sources[i])) {
+      fprintf(stderr, "Failed to allocate capture ring\n");
+      return -1;
+    }
+  }
+
+  ctx->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (ctx->wake_fd < 0) {
+    fprintf(stderr, "Failed to create wake eventfd\n");
+    return -1;
+  }
+  return 0;
+}
+
+// Initialize PipeWire audio capture for every configured source, writing
+// every buffer to a capture journal if journal_path is set
+audio_context_t *audio_init(const config_t *config, const char *journal_path) {
+  audio_context_t *ctx = context_new(config);
+  if (!ctx)
+    return NULL;
 
   // Initialize PipeWire
   pw_init(NULL, NULL);
+  ctx->pipewire = 1;
+
+  parse_sources(ctx, config->audio_source);
+  if (context_buffers(ctx) != 0) {
+    audio_cleanup(ctx);
+    return NULL;
+  }
+
+  // The journal is in place before the first callback
+  if (journal_path) {
+    ctx->journal = journal_open(journal_path, ctx->sample_rate,
+                                ctx->channels, ctx->num_sources,
+                                now_ns());
+    if (!ctx->journal) {
+      audio_cleanup(ctx);
+      return NULL;
+    }
+  }
 
   ctx->thread_loop = pw_thread_loop_new("audiovis", NULL);
   if (!ctx->thread_loop) {
     fprintf(stderr, "Failed to create PipeWire thread loop\n");
-    free(ctx);
+    audio_cleanup(ctx);
     return NULL;
   }
 
   struct pw_loop *loop = pw_thread_loop_get_loop(ctx->thread_loop);
 
-  // Create stream
-  ctx->stream = pw_stream_new_simple(
-      loop, "audiovis-capture",
-      pw_properties_new(PW_KEY_MEDIA_TYPE, "Audio", PW_KEY_MEDIA_CATEGORY,
-                        "Capture", PW_KEY_MEDIA_ROLE, "Music", NULL),
-      &stream_events, ctx);
+  // Connect every stream on the one thread loop
+  pw_thread_loop_lock(ctx->thread_loop);
+  for (int i = 0; i < ctx->num_sources; i++) {
+    if (connect_source(ctx, &ctx->sources[i], loop) != 0) {
+      pw_thread_loop_unlock(ctx->thread_loop);
+      audio_cleanup(ctx);
+      return NULL;
+    }
+  }
+  pw_thread_loop_unlock(ctx->thread_loop);
 
-  if (!ctx->stream) {
-    fprintf(stderr, "Failed to create PipeWire stream\n");
-    pw_thread_loop_destroy(ctx->thread_loop);
-    free(ctx);
+  // Start the thread loop
+  pw_thread_loop_start(ctx->thread_loop);
+
+  return ctx;
+}
+
+// Replay a capture journal instead of capturing: its buffers reach the
+// rings with their original sizes and timing. The journal's sample rate
+// replaces config->sample_rate.
+audio_context_t *audio_init_replay(const char *path, config_t *config) {
+  int sample_rate;
+  int channels;
+  int sources;
+  journal_reader_t *reader =
+      journal_reader_open(path, &sample_rate, &channels, &sources);
+  if (!reader)
     return NULL;
+
+  if (sources > AUDIO_MAX_SOURCES) {
+    fprintf(stderr, "Journal has %d sources, only %d are replayed\n", sources,
+            AUDIO_MAX_SOURCES);
+    sources = AUDIO_MAX_SOURCES;
   }
 
-  // Audio format parameters
-  uint8_t buffer[1024];
-  struct spa_pod_builder b = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
+  config->sample_rate = sample_rate;
+  audio_context_t *ctx = context_new(config);
+  if (!ctx) {
+    journal_reader_close(reader);
+    return NULL;
+  }
 
-  const struct spa_pod *params[1];
-  params[0] = spa_format_audio_raw_build(
-      &b, SPA_PARAM_EnumFormat,
-      &SPA_AUDIO_INFO_RAW_INIT(.format = SPA_AUDIO_FORMAT_F32,
-                               .channels = ctx->channels,
-                               .rate = ctx->sample_rate));
+  ctx->replay = reader;
+  ctx->channels = channels;
+  ctx->num_sources = sources;
+  for (int i = 0; i < sources; i++)
+    snprintf(ctx->sources[i].name, sizeof(ctx->sources[i].name),
+             "journal %d", i + 1);
 
-  // Connect stream
-  pw_thread_loop_lock(ctx->thread_loop);
+  if (context_buffers(ctx) != 0) {
+    audio_cleanup(ctx);
+    return NULL;
+  }
 
-  int ret = pw_stream_connect(ctx->stream, PW_DIRECTION_INPUT, PW_ID_ANY,
-                              PW_STREAM_FLAG_AUTOCONNECT |
-                                  PW_STREAM_FLAG_MAP_BUFFERS |
-                                  PW_STREAM_FLAG_RT_PROCESS,
-                              params, 1);
+  if (pthread_create(&ctx->feed_thread, NULL, replay_main, ctx) != 0) {
+    fprintf(stderr, "Failed to start journal replay\n");
+    audio_cleanup(ctx);
+    return NULL;
+  }
+  ctx->feed_started = 1;
+  return ctx;
+}
 
-  if (ret < 0) {
-    fprintf(stderr, "Failed to connect stream: error code %d\n", ret);
-    pw_thread_loop_unlock(ctx->thread_loop);
-    pw_stream_destroy(ctx->stream);
-    pw_thread_loop_destroy(ctx->thread_loop);
-    free(ctx);
+// Context without capture that the caller fills through audio_feed(),
+// usually from an audio_start_feeder() thread (soak tests): sources of
+// interleaved audio with the given channel count at config->sample_rate
+audio_context_t *audio_init_feed(const config_t *config, int channels,
+                                 int sources) {
+  if (channels < 1 || sources < 1 || sources > AUDIO_MAX_SOURCES) {
+    fprintf(stderr, "Cannot feed %d sources of %d channels\n", sources,
+            channels);
     return NULL;
   }
 
-  pw_thread_loop_unlock(ctx->thread_loop);
+  audio_context_t *ctx = context_new(config);
+  if (!ctx)
+    return NULL;
 
-  // Start the thread loop
-  pw_thread_loop_start(ctx->thread_loop);
+  ctx->channels = channels;
+  ctx->num_sources = sources;
+  for (int i = 0; i < sources; i++)
+    snprintf(ctx->sources[i].name, sizeof(ctx->sources[i].name), "feed %d",
+             i + 1);
 
+  if (context_buffers(ctx) != 0) {
+    audio_cleanup(ctx);
+    return NULL;
+  }
   return ctx;
 }
 
-// Get audio buffer for processing
-int audio_get_buffer(audio_context_t *ctx, float *buffer, int size) {
+// Run feeder on its own thread in place of capture until it returns -1
+// or audio_cleanup() stops it; returns -1 if the thread cannot start
+int audio_start_feeder(audio_context_t *ctx, audio_feeder_t feeder,
+                       void *arg) {
+  if (!ctx || ctx->feed_started)
+    return -1;
+
+  ctx->feeder = feeder;
+  ctx->feeder_arg = arg;
+  if (pthread_create(&ctx->feed_thread, NULL, feeder_main, ctx) != 0) {
+    fprintf(stderr, "Failed to start audio feeder\n");
+    return -1;
+  }
+  ctx->feed_started = 1;
+  return 0;
+}
+
+// Write one block of interleaved samples into a source's ring, as the
+// capture callback would, captured now
+void audio_feed(audio_context_t *ctx, int source, const float *samples,
+                int frames) {
+  if (!ctx || source < 0 || source >= ctx->num_sources || frames <= 0)
+    return;
+  write_block(&ctx->sources[source], samples, frames, now_ns());
+}
+
+// Number of captured sources
+int audio_source_count(audio_context_t *ctx) {
+  return ctx ? ctx->num_sources : 0;
+}
+
+// Configured name of a source ("auto" for the default one)
+const char *audio_source_name(audio_context_t *ctx, int source) {
+  if (!ctx || source < 0 || source >= ctx->num_sources)
+    return NULL;
+  return ctx->sources[source].name;
+}
+
+// Newest size samples of a source as one contiguous run inside its ring,
+// valid until the next call. *fresh receives how many samples arrived
+// since the previous call, and *fresh_samples where they start, also one
+// contiguous run. There may be more of them than size, up to the part of
+// the ring the window leaves untouched (RING_BUFFER_SIZE - size). Either
+// pointer may be NULL. Different sources may be read from different
+// threads.
+const float *audio_get_window(audio_context_t *ctx, int source, int size,
+                              const float **fresh_samples, int *fresh) {
+  if (!ctx || source < 0 || source >= ctx->num_sources || size <= 0 ||
+      size > MAX_WINDOW)
+    return NULL;
+
+  audio_source_t *src = &ctx->sources[source];
+  long trace_start = trace_begin();
+
+  pthread_mutex_lock(&ctx->mutex);
+  int pos = src->write_pos;
+  long written = src->written;
+  src->window_ns = src->captured_ns;
+  pthread_mutex_unlock(&ctx->mutex);
+
+  long count = written - src->read_mark;
+  if (count > RING_BUFFER_SIZE - size)
+    count = RING_BUFFER_SIZE - size;
+  if (fresh)
+    *fresh = (int)count;
+  if (fresh_samples)
+    *fresh_samples = src->ring + ((pos - count) & (RING_BUFFER_SIZE - 1));
+  src->read_mark = written;
+  trace_end("audio_get_window", trace_start);
+
+  return src->ring + ((pos - size) & (RING_BUFFER_SIZE - 1));
+}
+
+// Capture time (CLOCK_MONOTONIC) of the newest sample in the window last
+// returned by audio_get_window() for a source (0 before any audio)
+long audio_window_time(audio_context_t *ctx, int source) {
+  if (!ctx || source < 0 || source >= ctx->num_sources)
+    return 0;
+  return ctx->sources[source].window_ns;
+}
+
+// Milliseconds since the last non-silent block on any source (or since
+// init)
+long audio_silence_ms(audio_context_t *ctx) {
   if (!ctx)
     return 0;
 
   pthread_mutex_lock(&ctx->mutex);
+  long last = ctx->last_sound_ns;
+  pthread_mutex_unlock(&ctx->mutex);
 
-  int available =
-      (ctx->write_pos - ctx->read_pos + RING_BUFFER_SIZE) % RING_BUFFER_SIZE;
-  int to_read = (size < available) ? size : available;
+  return (now_ns() - last) / 1000000L;
+}
 
-  for (int i = 0; i < to_read; i++) {
-    buffer[i] = ctx->ring_buffer[ctx->read_pos];
-    ctx->read_pos = (ctx->read_pos + 1) % RING_BUFFER_SIZE;
-  }
+// Block without timeouts until sound resumes or input_fd is readable
+// (-1 to wait for sound only). Returns 1 when woken by sound, 0 on input
+// or signal.
+int audio_wait_for_sound(audio_context_t *ctx, int input_fd) {
+  if (!ctx)
+    return 0;
 
-  // Fill rest with zeros if not enough data
-  for (int i = to_read; i < size; i++) {
-    buffer[i] = 0.0f;
-  }
+  pthread_mutex_lock(&ctx->mutex);
+  ctx->idle = 1;
+  pthread_mutex_unlock(&ctx->mutex);
+
+  struct pollfd fds[2] = {
+      {.fd = ctx->wake_fd, .events = POLLIN},
+      {.fd = input_fd, .events = POLLIN},
+  };
+  poll(fds, 2, -1);
 
+  pthread_mutex_lock(&ctx->mutex);
+  ctx->idle = 0;
+  uint64_t count;
+  int woke = read(ctx->wake_fd, &count, sizeof(count)) > 0;
   pthread_mutex_unlock(&ctx->mutex);
 
-  return to_read;
+  return woke;
 }
 
-// Cleanup audio capture
+// Cleanup audio capture (also undoes a partial audio_init())
 void audio_cleanup(audio_context_t *ctx) {
   if (!ctx)
     return;
@@ -180,16 +733,35 @@ void audio_cleanup(audio_context_t *ctx) {
     pw_thread_loop_stop(ctx->thread_loop);
   }
 
-  if (ctx->stream) {
-    pw_stream_destroy(ctx->stream);
+  for (int i = 0; i < ctx->num_sources; i++) {
+    if (ctx->sources[i].stream) {
+      pw_stream_destroy(ctx->sources[i].stream);
+    }
   }
 
   if (ctx->thread_loop) {
     pw_thread_loop_destroy(ctx->thread_loop);
   }
 
+  // Nothing writes to the journal or the rings any more
+  journal_close(ctx->journal);
+  if (ctx->feed_started) {
+    __atomic_store_n(&ctx->feed_stop, 1, __ATOMIC_RELEASE);
+    pthread_join(ctx->feed_thread, NULL);
+  }
+  journal_reader_close(ctx->replay);
+
+  for (int i = 0; i < ctx->num_sources; i++) {
+    if (ctx->sources[i].ring) {
+      free_ring(&ctx->sources[i]);
+    }
+  }
+
   pthread_mutex_destroy(&ctx->mutex);
-  pw_deinit();
+  if (ctx->wake_fd >= 0)
+    close(ctx->wake_fd);
+  if (ctx->pipewire)
+    pw_deinit();
 
   free(ctx);
 }
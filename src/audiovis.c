@@ -0,0 +1,167 @@
+#include "audiovis.h"
+#include "config.h"
+#include "dsp.h"
+#include "fft.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Analyzer: an analysis context fed from a private sample history
+struct audiovis {
+  fft_context_t *fft;
+  int fft_size;
+  int bands;
+
+  // Mirrored history: each sample is stored at pos and pos + fft_size, so
+  // the newest fft_size samples always start contiguously at pos
+  float *history;
+  int pos;
+};
+
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+static void select_kernels(void) { dsp_init(NULL); }
+
+// Same defaults as the visualizer's configuration
+void audiovis_default_params(audiovis_params_t *params) {
+  config_t config;
+  config_set_defaults(&config);
+
+  params->sample_rate = config.sample_rate;
+  params->fft_size = config.buffer_size;
+  params->bands = config.bar_count;
+  params->min_freq = config.min_freq;
+  params->max_freq = config.max_freq;
+  params->engine = config.engine;
+  params->update_rate = config.fps;
+  params->sensitivity = config.sensitivity;
+  params->bass_boost = config.bass_boost;
+  params->db_floor = config.db_floor;
+  params->db_ceiling = config.db_ceiling;
+  params->attack_ms = config.attack_ms;
+  params->release_ms = config.release_ms;
+  params->peak_hold_ms = config.peak_hold_ms;
+  params->gravity = config.gravity;
+  params->agc = config.agc;
+  params->agc_window = config.agc_window;
+}
+
+// Create an analyzer; every buffer it will use is allocated here, and the
+// measured FFT plan is ready on return so results do not depend on timing
+audiovis_t *audiovis_create(const audiovis_params_t *params) {
+  if (!params || params->sample_rate <= 0 || params->fft_size < 16 ||
+      params->bands < 1 || params->min_freq <= 0 ||
+      params->max_freq <= params->min_freq || params->update_rate <= 0 ||
+      params->engine < AUDIOVIS_ENGINE_AUTO ||
+      params->engine > AUDIOVIS_ENGINE_FIXED) {
+    fprintf(stderr, "Invalid audiovis parameters\n");
+    return NULL;
+  }
+
+  pthread_once(&kernels_once, select_kernels);
+
+  config_t config;
+  config_set_defaults(&config);
+  config.sample_rate = params->sample_rate;
+  config.buffer_size = params->fft_size;
+  config.bar_count = params->bands;
+  config.min_freq = params->min_freq;
+  config.max_freq = params->max_freq;
+  config.engine = params->engine;
+  config.fps = params->update_rate;
+  config.sensitivity = params->sensitivity;
+  config.bass_boost = params->bass_boost;
+  config.db_floor = params->db_floor;
+  config.db_ceiling = params->db_ceiling;
+  config.attack_ms = params->attack_ms;
+  config.release_ms = params->release_ms;
+  config.peak_hold_ms = params->peak_hold_ms;
+  config.gravity = params->gravity;
+  config.agc = params->agc;
+  config.agc_window = params->agc_window;
+
+  audiovis_t *av = calloc(1, sizeof(audiovis_t));
+  if (!av) {
+    fprintf(stderr, "Failed to allocate audiovis analyzer\n");
+    return NULL;
+  }
+
+  av->fft_size = params->fft_size;
+  av->bands = params->bands;
+  av->history = calloc(2 * params->fft_size, sizeof(float));
+  if (!av->history) {
+    fprintf(stderr, "Failed to allocate audiovis history\n");
+    audiovis_destroy(av);
+    return NULL;
+  }
+
+  av->fft = fft_init(params->sample_rate, params->fft_size, &config);
+  if (!av->fft) {
+    audiovis_destroy(av);
+    return NULL;
+  }
+  fft_wait_plan(av->fft);
+
+  return av;
+}
+
+// Append mono samples; only the newest fft_size reach the FFT window, but
+// the sliding DFT sees every one
+void audiovis_push(audiovis_t *av, const float *samples, int count) {
+  if (!av || !samples || count <= 0)
+    return;
+
+  fft_push(av->fft, samples, count);
+
+  if (count > av->fft_size) {
+    samples += count - av->fft_size;
+    count = av->fft_size;
+  }
+
+  // Up to two runs: to the end of the ring, then from its start
+  while (count > 0) {
+    int run = av->fft_size - av->pos;
+    if (run > count)
+      run = count;
+
+    memcpy(av->history + av->pos, samples, run * sizeof(float));
+    memcpy(av->history + av->pos + av->fft_size, samples, run * sizeof(float));
+    av->pos = (av->pos + run) % av->fft_size;
+    samples += run;
+    count -= run;
+  }
+}
+
+// Analyse the newest window into out (0-1 per band), smoothing over dt
+// seconds since the previous spectrum (0 for the first); returns the
+// number of bands written (at most the bands the analyzer was created
+// with)
+int audiovis_spectrum(audiovis_t *av, float *out, int bands, float dt) {
+  if (!av || !out || bands <= 0)
+    return 0;
+
+  if (bands > av->bands)
+    bands = av->bands;
+  fft_process_dt(av->fft, av->history + av->pos, out, bands, dt);
+  return bands;
+}
+
+// Forget the sample history and smoothing state
+void audiovis_reset(audiovis_t *av) {
+  if (!av)
+    return;
+
+  memset(av->history, 0, 2 * av->fft_size * sizeof(float));
+  av->pos = 0;
+  fft_reset(av->fft);
+}
+
+void audiovis_destroy(audiovis_t *av) {
+  if (!av)
+    return;
+
+  fft_cleanup(av->fft);
+  free(av->history);
+  free(av);
+}
@@ -0,0 +1,356 @@
+#include "batch.h"
+#include "dsp.h"
+#include "fft.h"
+#include "pool.h"
+#include "record.h"
+#include "utils.h"
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Frames handed to a worker at a time
+#define BATCH_CHUNK 64
+
+// WAV sample encodings
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_FLOAT 3
+#define WAV_FORMAT_EXTENSIBLE 0xfffe
+
+// Decoded WAV header over the mapped file
+typedef struct {
+  const uint8_t *data; // First sample frame
+  long frames;
+  int channels;
+  int sample_rate;
+  int format; // WAV_FORMAT_PCM or WAV_FORMAT_FLOAT
+  int bits;
+  int block_align;
+} wav_t;
+
+// Shared state of one batch run
+typedef struct {
+  const wav_t *wav;
+  fft_context_t **fft; // One context (and plan) per worker
+  float **windows;     // One mono window per worker
+  float *spectrum;     // frames x bar_count
+  long frames;
+  long next_frame; // Next chunk start (atomic)
+  int hop;
+  int buffer_size;
+  int bar_count;
+} batch_t;
+
+static uint16_t read_u16(const uint8_t *p) { return p[0] | p[1] << 8; }
+
+static uint32_t read_u32(const uint8_t *p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Walk the RIFF chunks for the format and the sample data
+static int parse_wav(const uint8_t *file, size_t size, wav_t *wav) {
+  if (size < 12 || memcmp(file, "RIFF", 4) != 0 ||
+      memcmp(file + 8, "WAVE", 4) != 0)
+    return -1;
+
+  int have_format = 0;
+  size_t pos = 12;
+  while (pos + 8 <= size) {
+    const uint8_t *chunk = file + pos;
+    size_t length = read_u32(chunk + 4);
+    const uint8_t *body = chunk + 8;
+    if (length > size - pos - 8)
+      length = size - pos - 8; // Truncated file: use what is there
+
+    if (memcmp(chunk, "fmt ", 4) == 0 && length >= 16) {
+      wav->format = read_u16(body);
+      wav->channels = read_u16(body + 2);
+      wav->sample_rate = read_u32(body + 4);
+      wav->block_align = read_u16(body + 12);
+      wav->bits = read_u16(body + 14);
+      if (wav->format == WAV_FORMAT_EXTENSIBLE && length >= 26)
+        wav->format = read_u16(body + 24); // Sub-format GUID prefix
+      have_format = 1;
+    } else if (memcmp(chunk, "data", 4) == 0 && have_format) {
+      if (wav->channels < 1 || wav->block_align < 1 || wav->sample_rate < 1)
+        return -1;
+      wav->data = body;
+      wav->frames = length / wav->block_align;
+      break;
+    }
+
+    pos += 8 + length + (length & 1); // Chunks are word aligned
+  }
+
+  if (!wav->data)
+    return -1;
+
+  int supported = (wav->format == WAV_FORMAT_PCM &&
+                   (wav->bits == 16 || wav->bits == 24 || wav->bits == 32)) ||
+                  (wav->format == WAV_FORMAT_FLOAT && wav->bits == 32);
+  if (!supported || wav->block_align < wav->channels * wav->bits / 8)
+    return -1;
+
+  return 0;
+}
+
+// One sample as float in [-1, 1)
+static float read_sample(const wav_t *wav, const uint8_t *p) {
+  if (wav->format == WAV_FORMAT_FLOAT) {
+    float v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  switch (wav->bits) {
+  case 16:
+    return (int16_t)read_u16(p) * (1.0f / 32768.0f);
+  case 24:
+    return (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 |
+                     (uint32_t)p[2] << 24) *
+           (1.0f / 2147483648.0f);
+  default:
+    return (int32_t)read_u32(p) * (1.0f / 2147483648.0f);
+  }
+}
+
+// Mono window starting at frame start, zero-padded past the end; channels
+// mix the same way as live capture (dsp_downmix)
+static void read_window(const wav_t *wav, long start, float *out, int n) {
+  int bytes = wav->bits / 8;
+  for (int i = 0; i < n; i++) {
+    long frame = start + i;
+    if (frame >= wav->frames) {
+      out[i] = 0.0f;
+      continue;
+    }
+
+    const uint8_t *p = wav->data + frame * wav->block_align;
+    float sample = 0.0f;
+    for (int ch = 0; ch < wav->channels && ch < 2; ch++)
+      sample += read_sample(wav, p + ch * bytes);
+    out[i] = sample / wav->channels;
+  }
+}
+
+// Worker task: claim chunks of frames until none are left. Frames are
+// independent (smoothing runs afterwards), so the output does not depend
+// on which worker computed them.
+static void analyse_frames(void *arg, int worker) {
+  batch_t *b = arg;
+  float *window = b->windows[worker];
+
+  for (;;) {
+    long first = __atomic_fetch_add(&b->next_frame, BATCH_CHUNK,
+                                    __ATOMIC_RELAXED);
+    if (first >= b->frames)
+      return;
+
+    long last = first + BATCH_CHUNK < b->frames ? first + BATCH_CHUNK
+                                                 : b->frames;
+    for (long frame = first; frame < last; frame++) {
+      read_window(b->wav, frame * b->hop, window, b->buffer_size);
+      fft_process(b->fft[worker], window,
+                  b->spectrum + frame * b->bar_count, b->bar_count);
+    }
+  }
+}
+
+// Write the spectrum as CSV: time in seconds, then one column per bar
+static int write_csv(const char *path, const batch_t *b, int sample_rate) {
+  FILE *f = fopen(path, "w");
+  if (!f) {
+    fprintf(stderr, "Failed to open output: %s\n", path);
+    return -1;
+  }
+
+  fprintf(f, "time");
+  for (int bar = 0; bar < b->bar_count; bar++)
+    fprintf(f, ",bar%d", bar);
+  fprintf(f, "\n");
+
+  for (long frame = 0; frame < b->frames; frame++) {
+    const float *row = b->spectrum + frame * b->bar_count;
+    fprintf(f, "%.6f", (double)frame * b->hop / sample_rate);
+    for (int bar = 0; bar < b->bar_count; bar++)
+      fprintf(f, ",%.4f", row[bar]);
+    fprintf(f, "\n");
+  }
+
+  int failed = ferror(f);
+  if (fclose(f) != 0 || failed) {
+    fprintf(stderr, "Failed to write output: %s\n", path);
+    return -1;
+  }
+  return 0;
+}
+
+// Write the spectrum in the --record format, replayable with --replay
+static int write_recording(const char *path, const batch_t *b,
+                           const config_t *config) {
+  recorder_t *rec = record_open(path, config);
+  if (!rec)
+    return -1;
+
+  int ok = 1;
+  for (long frame = 0; ok && frame < b->frames; frame++) {
+    long timestamp_ns =
+        (long)((double)frame * b->hop * 1e9 / config->sample_rate);
+    ok = record_frame(rec, b->spectrum + frame * b->bar_count, b->bar_count,
+                      timestamp_ns);
+  }
+  record_close(rec);
+
+  if (!ok) {
+    fprintf(stderr, "Failed to write output: %s\n", path);
+    return -1;
+  }
+  return 0;
+}
+
+static int ends_with(const char *s, const char *suffix) {
+  size_t n = strlen(s);
+  size_t m = strlen(suffix);
+  return n >= m && strcasecmp(s + n - m, suffix) == 0;
+}
+
+// Analyse a WAV file into a spectrogram (CSV if output ends in .csv,
+// otherwise a spectrum recording). Returns 0 on success.
+int batch_run(const char *input, const char *output, const config_t *config,
+              int hop, int threads) {
+  int fd = open(input, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    fprintf(stderr, "Failed to open input: %s\n", input);
+    return -1;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    fprintf(stderr, "Failed to read input: %s\n", input);
+    close(fd);
+    return -1;
+  }
+
+  const uint8_t *file = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (file == MAP_FAILED) {
+    fprintf(stderr, "Failed to map input: %s\n", input);
+    return -1;
+  }
+
+  wav_t wav = {0};
+  if (parse_wav(file, st.st_size, &wav) != 0) {
+    fprintf(stderr,
+            "Unsupported input (expected 16/24/32-bit PCM or float WAV): %s\n",
+            input);
+    munmap((void *)file, st.st_size);
+    return -1;
+  }
+
+  // Same analysis as live, at the file's rate, on the FFT engine (the
+  // sliding DFT is sequential) or the fixed-point one if chosen, and
+  // without smoothing, which is applied in frame order afterwards. Gain
+  // control also depends on frame order and stays off.
+  config_t analysis = *config;
+  analysis.sample_rate = wav.sample_rate;
+  analysis.engine = config->engine == ENGINE_FIXED ? ENGINE_FIXED : ENGINE_FFT;
+  analysis.agc = 0;
+  analysis.attack_ms = 0;
+  analysis.release_ms = 0;
+  analysis.gravity = 0.0f;
+
+  if (hop <= 0)
+    hop = config->buffer_size / 2;
+  if (threads <= 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cpus > 0 ? (int)cpus : 1;
+  }
+
+  batch_t b = {
+      .wav = &wav,
+      .frames = wav.frames > 0 ? (wav.frames - 1) / hop + 1 : 0,
+      .hop = hop,
+      .buffer_size = config->buffer_size,
+      .bar_count = config->bar_count,
+  };
+  b.fft = calloc(threads, sizeof(fft_context_t *));
+  b.windows = calloc(threads, sizeof(float *));
+  b.spectrum = malloc(sizeof(float) * (b.frames > 0 ? b.frames : 1) *
+                      b.bar_count);
+
+  int result = -1;
+  worker_pool_t *pool = NULL;
+  if (!b.fft || !b.windows || !b.spectrum) {
+    fprintf(stderr, "Failed to allocate batch buffers\n");
+    goto out;
+  }
+
+  // Per-worker contexts on the estimated plan, which depends only on the
+  // FFT size: a measured plan is picked by timing, and a different plan
+  // may round differently, so output would vary between runs
+  for (int t = 0; t < threads; t++) {
+    b.fft[t] = fft_init_estimate(wav.sample_rate, b.buffer_size, &analysis);
+    b.windows[t] = malloc(sizeof(float) * b.buffer_size);
+    if (!b.fft[t] || !b.windows[t]) {
+      fprintf(stderr, "Failed to set up batch worker\n");
+      goto out;
+    }
+  }
+
+  pool = pool_init(threads);
+  if (!pool)
+    goto out;
+
+  long start_ns = now_ns();
+  pool_run(pool, analyse_frames, &b, threads);
+
+  // Temporal smoothing in frame order, as the live loop applies it, with
+  // the hop as the time between frames
+  float *state = calloc(3 * b.bar_count, sizeof(float));
+  if (!state) {
+    fprintf(stderr, "Failed to allocate batch buffers\n");
+    goto out;
+  }
+  dsp_smooth_t smooth;
+  dsp_smooth_params(&smooth, config->attack_ms, config->release_ms,
+                    config->peak_hold_ms, config->gravity,
+                    (float)hop / wav.sample_rate);
+  for (long frame = 0; frame < b.frames; frame++)
+    dsp_smooth(state, state + b.bar_count, state + 2 * b.bar_count,
+               b.spectrum + frame * b.bar_count, &smooth, b.bar_count);
+  free(state);
+  long elapsed_ns = now_ns() - start_ns;
+
+  config_t recorded = *config;
+  recorded.sample_rate = wav.sample_rate;
+  result = ends_with(output, ".csv")
+               ? write_csv(output, &b, wav.sample_rate)
+               : write_recording(output, &b, &recorded);
+
+  if (result == 0) {
+    double audio_s = (double)wav.frames / wav.sample_rate;
+    double elapsed_s = elapsed_ns / 1e9;
+    printf("Analysed %ld frames (%.1f s of audio) on %d threads in %.3f s"
+           " (%.1fx realtime)\n",
+           b.frames, audio_s, threads, elapsed_s,
+           elapsed_s > 0 ? audio_s / elapsed_s : 0.0);
+  }
+
+out:
+  pool_cleanup(pool);
+  for (int t = 0; b.fft && t < threads; t++)
+    fft_cleanup(b.fft[t]);
+  for (int t = 0; b.windows && t < threads; t++)
+    free(b.windows[t]);
+  free(b.fft);
+  free(b.windows);
+  free(b.spectrum);
+  munmap((void *)file, st.st_size);
+
+  return result;
+}
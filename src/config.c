@@ -1,5 +1,6 @@
 #include "config.h"
 #include "utils.h"
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -34,14 +35,26 @@ void config_set_defaults(config_t *config) {
 
   /* Processing defaults */
   config->sensitivity = 1.5f;
-  config->smoothing = 0.7f;
+  config->attack_ms = 47;
+  config->release_ms = 47;
+  config->peak_hold_ms = 0;
+  config->gravity = 0.0f;
   config->bass_boost = 1.2f;
   config->min_freq = 20;
   config->max_freq = 20000;
+  config->engine = 0;
+  config->db_floor = -70.0f;
+  config->db_ceiling = -20.0f;
+  config->agc = 0;
+  config->agc_window = 10;
 
   /* Performance defaults */
   config->fps = 60;
+  config->analysis_rate = 0;
   config->sleep_timer = 1000;
+  config->backend = 0;
+  config->render_threads = 0;
+  config->governor = 1;
 
   /* Layout defaults */
   config->orientation = 0;
@@ -88,14 +101,37 @@ static void parse_line(const char *section, const char *key, const char *value,
   } else if (strcmp(section, "processing") == 0) {
     if (strcmp(key, "sensitivity") == 0) {
       config->sensitivity = atof(value);
+    } else if (strcmp(key, "attack_ms") == 0) {
+      config->attack_ms = atoi(value);
+    } else if (strcmp(key, "release_ms") == 0) {
+      config->release_ms = atoi(value);
+    } else if (strcmp(key, "peak_hold_ms") == 0) {
+      config->peak_hold_ms = atoi(value);
+    } else if (strcmp(key, "gravity") == 0) {
+      config->gravity = atof(value);
     } else if (strcmp(key, "smoothing") == 0) {
-      config->smoothing = clamp(atof(value), 0.0f, 1.0f);
+      /* Older configs: a per-frame factor, tuned at 60 fps */
+      float factor = clamp(atof(value), 0.0f, 0.99f);
+      int ms = factor > 0.0f ? (int)(-1000.0f / (60.0f * logf(factor)) + 0.5f)
+                             : 0;
+      config->attack_ms = ms;
+      config->release_ms = ms;
     } else if (strcmp(key, "bass_boost") == 0) {
       config->bass_boost = atof(value);
     } else if (strcmp(key, "min_freq") == 0) {
       config->min_freq = atoi(value);
     } else if (strcmp(key, "max_freq") == 0) {
       config->max_freq = atoi(value);
+    } else if (strcmp(key, "engine") == 0) {
+      config->engine = atoi(value);
+    } else if (strcmp(key, "db_floor") == 0) {
+      config->db_floor = atof(value);
+    } else if (strcmp(key, "db_ceiling") == 0) {
+      config->db_ceiling = atof(value);
+    } else if (strcmp(key, "agc") == 0) {
+      config->agc = atoi(value);
+    } else if (strcmp(key, "agc_window") == 0) {
+      config->agc_window = atoi(value);
     }
 
   } else if (strcmp(section, "performance") == 0) {
@@ -103,6 +139,14 @@ static void parse_line(const char *section, const char *key, const char *value,
       config->fps = atoi(value);
     } else if (strcmp(key, "sleep_timer") == 0) {
       config->sleep_timer = atoi(value);
+    } else if (strcmp(key, "analysis_rate") == 0) {
+      config->analysis_rate = atoi(value);
+    } else if (strcmp(key, "backend") == 0) {
+      config->backend = atoi(value);
+    } else if (strcmp(key, "render_threads") == 0) {
+      config->render_threads = atoi(value);
+    } else if (strcmp(key, "governor") == 0) {
+      config->governor = atoi(value);
     }
 
   } else if (strcmp(section, "layout") == 0) {
@@ -187,14 +231,26 @@ int config_save(const char *filename, const config_t *config) {
 
   fprintf(file, "[processing]\n");
   fprintf(file, "sensitivity = %.2f\n", config->sensitivity);
-  fprintf(file, "smoothing = %.2f\n", config->smoothing);
+  fprintf(file, "attack_ms = %d\n", config->attack_ms);
+  fprintf(file, "release_ms = %d\n", config->release_ms);
+  fprintf(file, "peak_hold_ms = %d\n", config->peak_hold_ms);
+  fprintf(file, "gravity = %.2f\n", config->gravity);
   fprintf(file, "bass_boost = %.2f\n", config->bass_boost);
   fprintf(file, "min_freq = %d\n", config->min_freq);
-  fprintf(file, "max_freq = %d\n\n", config->max_freq);
+  fprintf(file, "max_freq = %d\n", config->max_freq);
+  fprintf(file, "engine = %d\n", config->engine);
+  fprintf(file, "db_floor = %.1f\n", config->db_floor);
+  fprintf(file, "db_ceiling = %.1f\n", config->db_ceiling);
+  fprintf(file, "agc = %d\n", config->agc);
+  fprintf(file, "agc_window = %d\n\n", config->agc_window);
 
   fprintf(file, "[performance]\n");
   fprintf(file, "fps = %d\n", config->fps);
-  fprintf(file, "sleep_timer = %d\n\n", config->sleep_timer);
+  fprintf(file, "analysis_rate = %d\n", config->analysis_rate);
+  fprintf(file, "sleep_timer = %d\n", config->sleep_timer);
+  fprintf(file, "backend = %d\n", config->backend);
+  fprintf(file, "render_threads = %d\n", config->render_threads);
+  fprintf(file, "governor = %d\n\n", config->governor);
 
   fprintf(file, "[layout]\n");
   fprintf(file, "orientation = %d\n", config->orientation);
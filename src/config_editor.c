@@ -84,13 +84,25 @@ int config_editor_run(config_t *config, const char *config_file) {
       {"Color Mid", 2, config->color_mid, 0, 0, 0, 0, 15},
       {"Color High", 2, config->color_high, 0, 0, 0, 0, 15},
       {"Sensitivity", 1, &config->sensitivity, 0.1f, 10.0f, 0, 0, 0},
-      {"Smoothing", 1, &config->smoothing, 0.0f, 1.0f, 0, 0, 0},
+      {"Attack (ms)", 0, &config->attack_ms, 0, 0, 0, 2000, 0},
+      {"Release (ms)", 0, &config->release_ms, 0, 0, 0, 5000, 0},
+      {"Peak Hold (ms)", 0, &config->peak_hold_ms, 0, 0, 0, 5000, 0},
+      {"Gravity", 1, &config->gravity, 0.0f, 100.0f, 0, 0, 0},
       {"Bass Boost", 1, &config->bass_boost, 0.5f, 5.0f, 0, 0, 0},
       {"Min Frequency", 0, &config->min_freq, 0, 0, 20, 20000, 0},
       {"Max Frequency", 0, &config->max_freq, 0, 0, 20, 20000, 0},
+      {"Engine (0-3)", 0, &config->engine, 0, 0, 0, 3, 0},
+      {"dB Floor", 1, &config->db_floor, -120.0f, 0.0f, 0, 0, 0},
+      {"dB Ceiling", 1, &config->db_ceiling, -100.0f, 20.0f, 0, 0, 0},
+      {"Auto Gain", 3, &config->agc, 0, 0, 0, 0, 0},
+      {"Auto Gain Window (s)", 0, &config->agc_window, 0, 0, 1, 120, 0},
       {"FPS", 0, &config->fps, 0, 0, 1, 120, 0},
+      {"Analysis Rate (0=FPS)", 0, &config->analysis_rate, 0, 0, 0, 240, 0},
       {"Sleep Timer (ms)", 0, &config->sleep_timer, 0, 0, 0, 10000, 0},
-      {"Orientation (0/1)", 0, &config->orientation, 0, 0, 0, 1, 0},
+      {"Backend (0-2)", 0, &config->backend, 0, 0, 0, 2, 0},
+      {"Render Threads (0=auto)", 0, &config->render_threads, 0, 0, 0, 64, 0},
+      {"Quality Governor", 3, &config->governor, 0, 0, 0, 0, 0},
+      {"Orientation (0-2)", 0, &config->orientation, 0, 0, 0, 2, 0},
       {"Reverse (0/1)", 3, &config->reverse, 0, 0, 0, 0, 0},
       {"Bar Width", 0, &config->bar_width, 0, 0, 1, 10, 0},
       {"Bar Spacing", 0, &config->bar_spacing, 0, 0, 0, 10, 0},
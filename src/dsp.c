@@ -0,0 +1,334 @@
+#include "dsp.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+// Precompute the Hann window used by fft_process()
+void dsp_hann_table(float *window, int n) {
+  for (int i = 0; i < n; i++) {
+    window[i] = 0.5f * (1.0f - cosf(2.0f * M_PI * i / (n - 1)));
+  }
+}
+
+// Precompute the logarithmic bar-to-bin map; returns the number of bins used
+int dsp_build_bands(dsp_band_t *bands, int bar_count, int sample_rate,
+                    int buffer_size, int min_freq, int max_freq) {
+  float freq_per_bin = (float)sample_rate / buffer_size;
+  int num_bins = buffer_size / 2 + 1;
+
+  int min_bin = (int)(min_freq / freq_per_bin);
+  int max_bin = (int)(max_freq / freq_per_bin);
+  if (max_bin >= num_bins)
+    max_bin = num_bins - 1;
+
+  float log_min = logf(fmaxf(1.0f, (float)min_freq));
+  float log_max = logf((float)max_freq);
+  float log_range = log_max - log_min;
+
+  int used = 0;
+  for (int bar = 0; bar < bar_count; bar++) {
+    float bar_log_min = log_min + (log_range * bar) / bar_count;
+    float bar_log_max = log_min + (log_range * (bar + 1)) / bar_count;
+
+    int start_bin = (int)(expf(bar_log_min) / freq_per_bin);
+    int end_bin = (int)(expf(bar_log_max) / freq_per_bin);
+
+    if (start_bin < min_bin)
+      start_bin = min_bin;
+    if (end_bin > max_bin)
+      end_bin = max_bin;
+    if (start_bin >= end_bin)
+      start_bin = end_bin - 1;
+    if (start_bin < 0)
+      start_bin = 0;
+
+    bands[bar].start = start_bin;
+    bands[bar].end = end_bin;
+    if (end_bin + 1 > used)
+      used = end_bin + 1;
+  }
+
+  return used;
+}
+
+// Per-bin power gain: bass boost (an amplitude factor) below 10% of the
+// spectrum
+void dsp_bass_gain(float *gain, int num_bins, float bass_boost) {
+  for (int bin = 0; bin < num_bins; bin++) {
+    gain[bin] = (bin < num_bins * 0.1f) ? bass_boost * bass_boost : 1.0f;
+  }
+}
+
+// Fold power scale and dB range into the db_scale kernel parameters:
+// out = ((10 log10(power * scale)) - floor) / (ceiling - floor)
+void dsp_db_params(float scale, float floor_db, float ceiling_db,
+                   float *offset, float *inv_range) {
+  float range = ceiling_db - floor_db;
+  if (range < 1.0f)
+    range = 1.0f;
+
+  *offset = DSP_DB_PER_LOG2 * log2f(scale) - floor_db;
+  *inv_range = 1.0f / range;
+}
+
+// Turn time constants into per-update weights for an update dt seconds
+// after the previous one, so bars move the same at any frame or hop rate.
+// A time constant of 0 follows the input instantly.
+void dsp_smooth_params(dsp_smooth_t *params, float attack_ms,
+                       float release_ms, float hold_ms, float gravity,
+                       float dt) {
+  params->attack = attack_ms > 0.0f ? expf(-dt * 1000.0f / attack_ms) : 0.0f;
+  params->release =
+      release_ms > 0.0f ? expf(-dt * 1000.0f / release_ms) : 0.0f;
+  params->hold = hold_ms > 0.0f ? hold_ms / 1000.0f : 0.0f;
+  params->half_gravity = gravity > 0.0f ? 0.5f * gravity : 0.0f;
+  params->dt = dt;
+}
+
+// Largest power-of-two decimation factor (up to 8) whose anti-alias
+// filter keeps max_freq clear of aliases within the tap limits; 1 when
+// max_freq is too close to Nyquist for decimation to pay off
+int dsp_decimation(int sample_rate, int buffer_size, int max_freq) {
+  for (int factor = 8; factor >= 2; factor /= 2) {
+    if (buffer_size / factor < DSP_MIN_DECIMATED)
+      continue;
+    int taps = dsp_lowpass_taps(sample_rate, factor, max_freq);
+    if (taps > 0 && taps <= DSP_MAX_TAPS && taps <= DSP_TAP_COST * factor)
+      return factor;
+  }
+  return 1;
+}
+
+// Taps of a Blackman-windowed sinc low-pass for decimating by factor: the
+// band between max_freq and the first alias of max_freq (the new sample
+// rate minus max_freq) is the transition band, about 5.5 / taps of the
+// sample rate wide. Returns 0 when the aliases would reach max_freq.
+int dsp_lowpass_taps(int sample_rate, int factor, int max_freq) {
+  float transition = (float)sample_rate / factor - 2.0f * max_freq;
+  if (max_freq <= 0 || transition <= 0.0f)
+    return 0;
+
+  int taps = (int)ceilf(5.5f * sample_rate / transition);
+  return (taps + DSP_TAP_BLOCK - 1) / DSP_TAP_BLOCK * DSP_TAP_BLOCK;
+}
+
+// Precompute the low-pass, cut off at the decimated Nyquist frequency
+// (the middle of the transition band) with unity gain at DC. The taps are
+// symmetric, so they need no reversal for dsp_decimate().
+void dsp_lowpass_table(float *taps, int num_taps, int factor) {
+  float center = (num_taps - 1) / 2.0f;
+  float cutoff = 0.5f / factor; // Cycles per input sample
+  float sum = 0.0f;
+
+  for (int i = 0; i < num_taps; i++) {
+    float x = 2.0f * cutoff * (i - center);
+    float sinc = x != 0.0f ? sinf(M_PI * x) / (M_PI * x) : 1.0f;
+    float phase = 2.0f * M_PI * i / (num_taps - 1);
+    float blackman = 0.42f - 0.5f * cosf(phase) + 0.08f * cosf(2.0f * phase);
+    taps[i] = sinc * blackman;
+    sum += taps[i];
+  }
+
+  for (int i = 0; i < num_taps; i++) {
+    taps[i] /= sum;
+  }
+}
+
+// Apply precomputed window
+static void window_scalar(const float *in, const float *window, float *out,
+                          int n) {
+  for (int i = 0; i < n; i++) {
+    out[i] = in[i] * window[i];
+  }
+}
+
+// Power of interleaved complex bins, with per-bin gain
+static void power_scalar(const float *bins, const float *gain, float *power,
+                         int n) {
+  for (int i = 0; i < n; i++) {
+    float real = bins[2 * i];
+    float imag = bins[2 * i + 1];
+    power[i] = (real * real + imag * imag) * gain[i];
+  }
+}
+
+// Map power to the 0-1 display range through the fast log2
+static void db_scale_scalar(const float *power, float *out, int n,
+                            float offset, float inv_range) {
+  for (int i = 0; i < n; i++) {
+    float p = power[i] > DSP_POWER_FLOOR ? power[i] : DSP_POWER_FLOOR;
+    float v = (DSP_DB_PER_LOG2 * dsp_fast_log2(p) + offset) * inv_range;
+    out[i] = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+  }
+}
+
+// Attack/release smoothing against the previous level, then peak falloff
+static void smooth_scalar(float *state, float *peak, float *age,
+                          float *values, const dsp_smooth_t *params, int n) {
+  for (int i = 0; i < n; i++) {
+    float a = values[i] > state[i] ? params->attack : params->release;
+    float level = values[i] + (state[i] - values[i]) * a;
+    state[i] = level;
+    values[i] = level;
+  }
+
+  if (params->half_gravity <= 0.0f)
+    return;
+
+  for (int i = 0; i < n; i++) {
+    float since = age[i] + params->dt;
+    float t = since - params->hold;
+    t = t > 0.0f ? t : 0.0f;
+    float fall = peak[i] - params->half_gravity * t * t;
+    if (values[i] >= fall) {
+      peak[i] = values[i];
+      age[i] = 0.0f;
+    } else {
+      age[i] = since;
+      values[i] = fall;
+    }
+  }
+}
+
+static const dsp_kernels_t dsp_kernels_scalar = {
+    "scalar",      window_scalar,   power_scalar,    db_scale_scalar,
+    smooth_scalar, dsp_downmix_scalar, dsp_decimate_scalar,
+};
+
+// Variants in order of preference
+static const dsp_kernels_t *const variants[] = {
+#if defined(__x86_64__) || defined(__i386__)
+    &dsp_kernels_avx512,
+    &dsp_kernels_avx2,
+    &dsp_kernels_sse2,
+#endif
+#if defined(__aarch64__)
+    &dsp_kernels_neon,
+#endif
+    &dsp_kernels_scalar,
+};
+
+#define NUM_VARIANTS (int)(sizeof(variants) / sizeof(variants[0]))
+
+static const dsp_kernels_t *active = &dsp_kernels_scalar;
+
+// Check whether the running CPU can execute a kernel set
+static int variant_supported(const dsp_kernels_t *k) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (k == &dsp_kernels_avx512)
+    return __builtin_cpu_supports("avx512f");
+  if (k == &dsp_kernels_avx2)
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  if (k == &dsp_kernels_sse2)
+    return __builtin_cpu_supports("sse2");
+#endif
+  (void)k;
+  return 1;
+}
+
+// Select the best supported kernel set, or the named one
+int dsp_init(const char *isa) {
+  for (int i = 0; i < NUM_VARIANTS; i++) {
+    if (!variant_supported(variants[i]))
+      continue;
+    if (isa && strcmp(isa, variants[i]->name) != 0)
+      continue;
+    active = variants[i];
+    return 0;
+  }
+
+  fprintf(stderr, "DSP kernels '%s' not available on this CPU\n", isa);
+  return -1;
+}
+
+// Name of the selected kernel set
+const char *dsp_isa(void) { return active->name; }
+
+// Number of kernel sets supported on this CPU
+int dsp_variant_count(void) {
+  int count = 0;
+  for (int i = 0; i < NUM_VARIANTS; i++)
+    count += variant_supported(variants[i]) ? 1 : 0;
+  return count;
+}
+
+// Supported kernel set by index, best first
+const dsp_kernels_t *dsp_variant(int index) {
+  for (int i = 0; i < NUM_VARIANTS; i++) {
+    if (variant_supported(variants[i]) && index-- == 0)
+      return variants[i];
+  }
+  return NULL;
+}
+
+void dsp_window(const float *in, const float *window, float *out, int n) {
+  active->window(in, window, out, n);
+}
+
+void dsp_power(const float *bins, const float *gain, float *power, int n) {
+  active->power(bins, gain, power, n);
+}
+
+void dsp_db_scale(const float *power, float *out, int n, float offset,
+                  float inv_range) {
+  active->db_scale(power, out, n, offset, inv_range);
+}
+
+void dsp_smooth(float *state, float *peak, float *age, float *values,
+                const dsp_smooth_t *params, int n) {
+  active->smooth(state, peak, age, values, params, n);
+}
+
+void dsp_downmix(const float *in, float *out, int frames, int channels) {
+  active->downmix(in, out, frames, channels);
+}
+
+void dsp_decimate(const float *in, const float *taps, int num_taps,
+                  int factor, float *out, int n) {
+  active->decimate(in, taps, num_taps, factor, out, n);
+}
+
+// Average bin power into bars using the precomputed map
+void dsp_bin_bands(const float *power, const dsp_band_t *bands, float *out,
+                   int bar_count) {
+  for (int bar = 0; bar < bar_count; bar++) {
+    float sum = 0.0f;
+    int bin_count = 0;
+
+    for (int bin = bands[bar].start; bin <= bands[bar].end; bin++) {
+      sum += power[bin];
+      bin_count++;
+    }
+
+    out[bar] = bin_count > 0 ? sum / bin_count : sum;
+  }
+}
+
+// Interleaved frames to mono (at most two channels summed); the scalar
+// variant, also used by the SIMD variants for other channel counts
+void dsp_downmix_scalar(const float *in, float *out, int frames,
+                        int channels) {
+  for (int i = 0; i < frames; i++) {
+    float sample = 0.0f;
+    for (int ch = 0; ch < channels && ch < 2; ch++) {
+      sample += in[i * channels + ch];
+    }
+    out[i] = sample / channels;
+  }
+}
+
+// FIR filter evaluated only at every factor-th input sample (the
+// polyphase form of filter-then-discard), the scalar variant:
+// out[i] = sum of taps[k] * in[i * factor + k]
+void dsp_decimate_scalar(const float *in, const float *taps, int num_taps,
+                         int factor, float *out, int n) {
+  for (int i = 0; i < n; i++) {
+    const float *x = in + (long)i * factor;
+    float sum = 0.0f;
+    for (int k = 0; k < num_taps; k++) {
+      sum += taps[k] * x[k];
+    }
+    out[i] = sum;
+  }
+}
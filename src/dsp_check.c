@@ -0,0 +1,660 @@
+#include "dsp.h"
+#include "fixed.h"
+#include "utils.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Documented tolerances for optimized kernels against the reference.
+// Window, power and smoothing are element-wise and may differ only by
+// rounding (reassociation or fused multiply-add). The stereo downmix is a
+// single add and halving, so every variant must match exactly. Binning sums up to
+// several hundred bins, so a reordered (vectorized) sum is checked with a
+// relative bound instead. The dB mapping replaces log10f with a polynomial
+// log2 and is checked against the exact curve in decibels. Smoothing
+// results that come close to cancelling (a fast release from full height,
+// a peak that has nearly fallen) may also be off by a tiny absolute
+// amount, far below one screen cell. Decimation sums up to DSP_MAX_TAPS
+// products in vector order; with inputs within [-1, 1] and unity-gain taps
+// it is checked with an absolute bound. The fixed-point engine is checked
+// end to end against a double-precision DFT, in dB, on every bar above
+// the default db_floor: its magnitude approximation alone is within
+// 0.25 dB, and Q15 rounding matters only near the floor.
+#define TOL_WINDOW_ULP 2
+#define TOL_POWER_ULP 2
+#define TOL_SMOOTH_ULP 2
+#define TOL_SMOOTH_ABS 1e-6f
+#define TOL_DOWNMIX_ULP 0
+#define TOL_BANDS_REL 1e-5f
+#define TOL_DB 1e-3f
+#define TOL_DECIMATE_ABS 1e-5f
+#define TOL_FIXED_DB 0.5f
+
+// Timed calls are repeated so short kernels measure above clock overhead
+#define REPEAT 64
+
+#define TIME_REPEAT(total, call)                                               \
+  do {                                                                         \
+    long start_ns_ = now_ns();                                                 \
+    for (int r_ = 0; r_ < REPEAT; r_++) {                                      \
+      call;                                                                    \
+    }                                                                          \
+    (total) += now_ns() - start_ns_;                                           \
+  } while (0)
+
+#define MAX_BUFFER 8192
+#define MAX_BARS 256
+
+static const int buffer_sizes[] = {256, 512, 1024, 2048, 4096, 8192};
+static const int bar_counts[] = {8, 16, 32, 64, 128, 256};
+
+#define NUM_BUFFER_SIZES (int)(sizeof(buffer_sizes) / sizeof(buffer_sizes[0]))
+#define NUM_BAR_COUNTS (int)(sizeof(bar_counts) / sizeof(bar_counts[0]))
+
+// Test signal kinds
+enum { SIG_NOISE, SIG_SINE, SIG_IMPULSE, SIG_SILENCE, SIG_SQUARE, NUM_SIGNALS };
+
+static const char *signal_names[] = {"noise", "sine", "impulse", "silence",
+                                     "square"};
+
+static uint32_t rng_state = 0x12345678u;
+
+static float rand_uniform(void) {
+  rng_state = rng_state * 1664525u + 1013904223u;
+  return (rng_state >> 8) * (1.0f / 16777216.0f) * 2.0f - 1.0f;
+}
+
+static void make_signal(float *out, int n, int kind) {
+  for (int i = 0; i < n; i++) {
+    switch (kind) {
+    case SIG_NOISE:
+      out[i] = rand_uniform();
+      break;
+    case SIG_SINE:
+      out[i] = 0.8f * sinf(2.0f * M_PI * 440.0f * i / 44100.0f) +
+               0.1f * sinf(2.0f * M_PI * 7000.0f * i / 44100.0f);
+      break;
+    case SIG_IMPULSE:
+      out[i] = (i == n / 3) ? 1.0f : 0.0f;
+      break;
+    case SIG_SILENCE:
+      out[i] = 0.0f;
+      break;
+    default:
+      out[i] = ((i / 50) & 1) ? 1.0f : -1.0f;
+      break;
+    }
+  }
+}
+
+// Complex bins with a wide dynamic range, like real FFT output
+static void make_bins(float *bins, int num_bins) {
+  for (int i = 0; i < 2 * num_bins; i++) {
+    bins[i] = rand_uniform() * powf(10.0f, 3.0f * rand_uniform());
+  }
+}
+
+// Distance in representable floats between a and b
+static uint32_t ulp_diff(float a, float b) {
+  if (a == b)
+    return 0;
+  int32_t ia, ib;
+  memcpy(&ia, &a, sizeof(ia));
+  memcpy(&ib, &b, sizeof(ib));
+  if (ia < 0)
+    ia = INT32_MIN - ia;
+  if (ib < 0)
+    ib = INT32_MIN - ib;
+  int64_t d = (int64_t)ia - ib;
+  return (uint32_t)(d < 0 ? -d : d);
+}
+
+static float rel_diff(float a, float b) {
+  float scale = fmaxf(fabsf(a), fabsf(b));
+  return scale > 0.0f ? fabsf(a - b) / scale : 0.0f;
+}
+
+// Reference: window computed per sample
+static void window_ref(const float *in, float *out, int n) {
+  for (int i = 0; i < n; i++) {
+    float window = 0.5f * (1.0f - cosf(2.0f * M_PI * i / (n - 1)));
+    out[i] = in[i] * window;
+  }
+}
+
+// Reference: per-bin power with inline bass boost
+static void power_ref(const float *bins, int num_bins, float bass_boost,
+                      float *power, int n) {
+  for (int bin = 0; bin < n; bin++) {
+    float real = bins[2 * bin];
+    float imag = bins[2 * bin + 1];
+    float p = real * real + imag * imag;
+
+    if (bin < num_bins * 0.1f) {
+      p *= bass_boost * bass_boost;
+    }
+
+    power[bin] = p;
+  }
+}
+
+// Reference: per-bar band edges, power and averaging in one loop
+static void bin_bands_ref(const float *bins, int bar_count, int sample_rate,
+                          int buffer_size, int min_freq, int max_freq,
+                          float bass_boost, float *out) {
+  float freq_per_bin = (float)sample_rate / buffer_size;
+  int num_bins = buffer_size / 2 + 1;
+
+  int min_bin = (int)(min_freq / freq_per_bin);
+  int max_bin = (int)(max_freq / freq_per_bin);
+  if (max_bin >= num_bins)
+    max_bin = num_bins - 1;
+
+  float log_min = logf(fmaxf(1.0f, (float)min_freq));
+  float log_max = logf((float)max_freq);
+  float log_range = log_max - log_min;
+
+  for (int bar = 0; bar < bar_count; bar++) {
+    float bar_log_min = log_min + (log_range * bar) / bar_count;
+    float bar_log_max = log_min + (log_range * (bar + 1)) / bar_count;
+
+    int start_bin = (int)(expf(bar_log_min) / freq_per_bin);
+    int end_bin = (int)(expf(bar_log_max) / freq_per_bin);
+
+    if (start_bin < min_bin)
+      start_bin = min_bin;
+    if (end_bin > max_bin)
+      end_bin = max_bin;
+    if (start_bin >= end_bin)
+      start_bin = end_bin - 1;
+    if (start_bin < 0)
+      start_bin = 0;
+
+    float sum = 0.0f;
+    int bin_count = 0;
+
+    for (int bin = start_bin; bin <= end_bin; bin++) {
+      float real = bins[2 * bin];
+      float imag = bins[2 * bin + 1];
+      float p = real * real + imag * imag;
+
+      if (bin < num_bins * 0.1f) {
+        p *= bass_boost * bass_boost;
+      }
+
+      sum += p;
+      bin_count++;
+    }
+
+    if (bin_count > 0) {
+      sum /= bin_count;
+    }
+
+    out[bar] = sum;
+  }
+}
+
+// Reference: exact dB mapping with log10f
+static void db_scale_ref(const float *power, float *out, int n, float scale,
+                         float floor_db, float ceiling_db) {
+  float range = ceiling_db - floor_db;
+  if (range < 1.0f)
+    range = 1.0f;
+
+  for (int i = 0; i < n; i++) {
+    float p = power[i] * scale;
+    float db = p > 0.0f ? 10.0f * log10f(p) : -1000.0f;
+    out[i] = fminf(fmaxf((db - floor_db) / range, 0.0f), 1.0f);
+  }
+}
+
+// Reference: per-bar attack/release smoothing and gravity peaks
+static void smooth_ref(float *state, float *peak, float *age, float *values,
+                       const dsp_smooth_t *params, int n) {
+  for (int bar = 0; bar < n; bar++) {
+    float weight =
+        values[bar] > state[bar] ? params->attack : params->release;
+    float magnitude = values[bar] + (state[bar] - values[bar]) * weight;
+    state[bar] = magnitude;
+    values[bar] = magnitude;
+
+    if (params->half_gravity > 0.0f) {
+      float since_peak = age[bar] + params->dt;
+      float since_hold = fmaxf(since_peak - params->hold, 0.0f);
+      float falling =
+          peak[bar] - params->half_gravity * since_hold * since_hold;
+      if (magnitude >= falling) {
+        peak[bar] = magnitude;
+        age[bar] = 0.0f;
+      } else {
+        age[bar] = since_peak;
+        values[bar] = falling;
+      }
+    }
+  }
+}
+
+// Accuracy and timing totals for one kernel
+typedef struct {
+  const char *name;
+  uint32_t max_ulp;
+  float max_rel;
+  float max_db;
+  long scalar_ns;
+  long opt_ns;
+  int failures;
+} kernel_stats_t;
+
+static void report(const kernel_stats_t *k) {
+  printf("  %-10s max %6u ulp  max rel %.2e  max %.1e dB  scalar %8.1f us"
+         "  opt %9.1f us  speedup %5.2fx  %s\n",
+         k->name, k->max_ulp, k->max_rel, k->max_db, k->scalar_ns / 1e3,
+         k->opt_ns / 1e3,
+         k->opt_ns > 0 ? (double)k->scalar_ns / k->opt_ns : 0.0,
+         k->failures ? "FAIL" : "ok");
+}
+
+// Scratch buffers shared by all variant checks
+typedef struct {
+  float *signal;
+  float *stereo;
+  float *window;
+  float *out_ref;
+  float *out_opt;
+  float *taps;
+  float *bins;
+  float *gain;
+  float *power;
+  float *state_ref; // Smoothed levels, peaks and peak ages (MAX_BARS each)
+  float *state_opt;
+  dsp_band_t *bands;
+} check_buffers_t;
+
+// Check one kernel set against the reference kernels and time it against
+// the scalar set; returns failure count
+static int check_variant(const dsp_kernels_t *k, const dsp_kernels_t *scalar,
+                         check_buffers_t *b, int verbose) {
+  kernel_stats_t window_stats = {.name = "window"};
+  kernel_stats_t power_stats = {.name = "power"};
+  kernel_stats_t band_stats = {.name = "binning"};
+  kernel_stats_t db_stats = {.name = "db_scale"};
+  kernel_stats_t smooth_stats = {.name = "smoothing"};
+  kernel_stats_t downmix_stats = {.name = "downmix"};
+  kernel_stats_t decimate_stats = {.name = "decimate"};
+  const float bass_boost = 1.2f;
+  dsp_smooth_t smooth;
+  const float floor_db = -70.0f;
+  const float ceiling_db = -20.0f;
+
+  for (int s = 0; s < NUM_BUFFER_SIZES; s++) {
+    int n = buffer_sizes[s];
+    int num_bins = n / 2 + 1;
+    dsp_hann_table(b->window, n);
+    dsp_bass_gain(b->gain, num_bins, bass_boost);
+
+    // Windowing and downmix over every synthetic signal
+    for (int kind = 0; kind < NUM_SIGNALS; kind++) {
+      make_signal(b->signal, n, kind);
+
+      window_ref(b->signal, b->out_ref, n);
+      TIME_REPEAT(window_stats.scalar_ns,
+                  scalar->window(b->signal, b->window, b->out_opt, n));
+      TIME_REPEAT(window_stats.opt_ns,
+                  k->window(b->signal, b->window, b->out_opt, n));
+
+      uint32_t worst = 0;
+      for (int i = 0; i < n; i++) {
+        uint32_t d = ulp_diff(b->out_ref[i], b->out_opt[i]);
+        if (d > worst)
+          worst = d;
+      }
+      if (worst > window_stats.max_ulp)
+        window_stats.max_ulp = worst;
+      if (worst > TOL_WINDOW_ULP) {
+        window_stats.failures++;
+        if (verbose)
+          printf("%s window: n=%d signal=%s off by %u ulp\n", k->name, n,
+                 signal_names[kind], worst);
+      }
+
+      // Stereo frames: the signal on the left, noise on the right
+      for (int i = 0; i < n; i++) {
+        b->stereo[2 * i] = b->signal[i];
+        b->stereo[2 * i + 1] = rand_uniform();
+      }
+
+      dsp_downmix_scalar(b->stereo, b->out_ref, n, 2);
+      TIME_REPEAT(downmix_stats.scalar_ns,
+                  scalar->downmix(b->stereo, b->out_opt, n, 2));
+      TIME_REPEAT(downmix_stats.opt_ns,
+                  k->downmix(b->stereo, b->out_opt, n, 2));
+
+      worst = 0;
+      for (int i = 0; i < n; i++) {
+        uint32_t d = ulp_diff(b->out_ref[i], b->out_opt[i]);
+        if (d > worst)
+          worst = d;
+      }
+      if (worst > downmix_stats.max_ulp)
+        downmix_stats.max_ulp = worst;
+      if (worst > TOL_DOWNMIX_ULP) {
+        downmix_stats.failures++;
+        if (verbose)
+          printf("%s downmix: n=%d signal=%s off by %u ulp\n", k->name, n,
+                 signal_names[kind], worst);
+      }
+
+      // Decimation by 2, 4 and 8; odd signal kinds use a tap count that is
+      // not a whole number of vectors to cover the tails
+      int factor = 2 << (s % 3);
+      int num_taps = 16 * factor - (kind & 1 ? 5 : 0);
+      int outputs = (n - num_taps) / factor + 1;
+      dsp_lowpass_table(b->taps, num_taps, factor);
+
+      dsp_decimate_scalar(b->signal, b->taps, num_taps, factor, b->out_ref,
+                          outputs);
+      TIME_REPEAT(decimate_stats.scalar_ns,
+                  scalar->decimate(b->signal, b->taps, num_taps, factor,
+                                   b->out_opt, outputs));
+      TIME_REPEAT(decimate_stats.opt_ns,
+                  k->decimate(b->signal, b->taps, num_taps, factor,
+                              b->out_opt, outputs));
+
+      for (int i = 0; i < outputs; i++) {
+        float diff = fabsf(b->out_ref[i] - b->out_opt[i]);
+        if (diff > TOL_DECIMATE_ABS) {
+          decimate_stats.failures++;
+          if (verbose)
+            printf("%s decimate: n=%d factor=%d signal=%s off by %.2e\n",
+                   k->name, n, factor, signal_names[kind], diff);
+          break;
+        }
+      }
+    }
+
+    // Power over randomized bins
+    make_bins(b->bins, num_bins);
+
+    power_ref(b->bins, num_bins, bass_boost, b->out_ref, num_bins);
+    TIME_REPEAT(power_stats.scalar_ns,
+                scalar->power(b->bins, b->gain, b->out_opt, num_bins));
+    TIME_REPEAT(power_stats.opt_ns,
+                k->power(b->bins, b->gain, b->out_opt, num_bins));
+
+    for (int i = 0; i < num_bins; i++) {
+      uint32_t d = ulp_diff(b->out_ref[i], b->out_opt[i]);
+      if (d > power_stats.max_ulp)
+        power_stats.max_ulp = d;
+      if (d > TOL_POWER_ULP) {
+        power_stats.failures++;
+        if (verbose)
+          printf("%s power: n=%d bin=%d off by %u ulp\n", k->name, n, i, d);
+        break;
+      }
+    }
+
+    // dB mapping of that power with the FFT's full-scale reference, so the
+    // random bins span the floor, the display range and the ceiling
+    memcpy(b->power, b->out_ref, sizeof(float) * num_bins);
+    float scale = 16.0f / ((float)n * n);
+    float offset, inv_range;
+    dsp_db_params(scale, floor_db, ceiling_db, &offset, &inv_range);
+
+    db_scale_ref(b->power, b->out_ref, num_bins, scale, floor_db,
+                 ceiling_db);
+    TIME_REPEAT(db_stats.scalar_ns, scalar->db_scale(b->power, b->out_opt,
+                                                     num_bins, offset,
+                                                     inv_range));
+    TIME_REPEAT(db_stats.opt_ns, k->db_scale(b->power, b->out_opt, num_bins,
+                                             offset, inv_range));
+
+    for (int i = 0; i < num_bins; i++) {
+      float db = fabsf(b->out_ref[i] - b->out_opt[i]) * (ceiling_db - floor_db);
+      uint32_t d = ulp_diff(b->out_ref[i], b->out_opt[i]);
+      if (d > db_stats.max_ulp)
+        db_stats.max_ulp = d;
+      if (db > db_stats.max_db)
+        db_stats.max_db = db;
+      if (db > TOL_DB) {
+        db_stats.failures++;
+        if (verbose)
+          printf("%s db_scale: n=%d bin=%d off by %.2e dB\n", k->name, n, i,
+                 db);
+        break;
+      }
+    }
+
+    for (int c = 0; c < NUM_BAR_COUNTS; c++) {
+      int bars = bar_counts[c];
+
+      // Binning: reference per-bar loop vs power + band map
+      bin_bands_ref(b->bins, bars, 44100, n, 20, 20000, bass_boost,
+                    b->out_ref);
+
+      int used = dsp_build_bands(b->bands, bars, 44100, n, 20, 20000);
+      TIME_REPEAT(band_stats.scalar_ns, {
+        scalar->power(b->bins, b->gain, b->power, used);
+        dsp_bin_bands(b->power, b->bands, b->out_opt, bars);
+      });
+      TIME_REPEAT(band_stats.opt_ns, {
+        k->power(b->bins, b->gain, b->power, used);
+        dsp_bin_bands(b->power, b->bands, b->out_opt, bars);
+      });
+
+      for (int i = 0; i < bars; i++) {
+        float r = rel_diff(b->out_ref[i], b->out_opt[i]);
+        if (r > band_stats.max_rel)
+          band_stats.max_rel = r;
+        uint32_t d = ulp_diff(b->out_ref[i], b->out_opt[i]);
+        if (d > band_stats.max_ulp)
+          band_stats.max_ulp = d;
+        if (r > TOL_BANDS_REL) {
+          band_stats.failures++;
+          if (verbose)
+            printf("%s binning: n=%d bars=%d bar=%d rel %.2e\n", k->name, n,
+                   bars, i, r);
+          break;
+        }
+      }
+
+      // Smoothing over a run of frames with varying time constants and
+      // frame intervals, with and without gravity peaks; each step starts
+      // from the reference state so rounding differences do not compound
+      for (int i = 0; i < 3 * MAX_BARS; i++)
+        b->state_ref[i] = fabsf(rand_uniform());
+
+      for (int frame = 0; frame < 16; frame++) {
+        memcpy(b->state_opt, b->state_ref, sizeof(float) * 3 * MAX_BARS);
+        for (int i = 0; i < bars; i++)
+          b->out_ref[i] = b->out_opt[i] = fabsf(rand_uniform());
+        dsp_smooth_params(&smooth, 200.0f * fabsf(rand_uniform()),
+                          500.0f * fabsf(rand_uniform()),
+                          300.0f * fabsf(rand_uniform()),
+                          frame & 1 ? 10.0f * fabsf(rand_uniform()) : 0.0f,
+                          0.05f * fabsf(rand_uniform()));
+
+        smooth_ref(b->state_ref, b->state_ref + MAX_BARS,
+                   b->state_ref + 2 * MAX_BARS, b->out_ref, &smooth, bars);
+        k->smooth(b->state_opt, b->state_opt + MAX_BARS,
+                  b->state_opt + 2 * MAX_BARS, b->out_opt, &smooth, bars);
+
+        for (int i = 0; i < bars; i++) {
+          uint32_t d = ulp_diff(b->out_ref[i], b->out_opt[i]);
+          if (fabsf(b->out_ref[i] - b->out_opt[i]) <= TOL_SMOOTH_ABS)
+            continue;
+          if (d > smooth_stats.max_ulp)
+            smooth_stats.max_ulp = d;
+          if (d > TOL_SMOOTH_ULP) {
+            smooth_stats.failures++;
+            if (verbose)
+              printf("%s smoothing: bars=%d bar=%d off by %u ulp\n", k->name,
+                     bars, i, d);
+            break;
+          }
+        }
+      }
+
+      // Timed separately since smoothing updates its state in place
+      float *level = b->power;
+      memcpy(level, b->state_ref, sizeof(float) * 3 * MAX_BARS);
+      TIME_REPEAT(smooth_stats.scalar_ns,
+                  scalar->smooth(level, level + MAX_BARS, level + 2 * MAX_BARS,
+                                 b->out_ref, &smooth, bars));
+      TIME_REPEAT(smooth_stats.opt_ns,
+                  k->smooth(level, level + MAX_BARS, level + 2 * MAX_BARS,
+                            b->out_opt, &smooth, bars));
+    }
+  }
+
+  printf("%s kernels vs reference, timed vs scalar (%d buffer sizes, "
+         "%d bar counts):\n",
+         k->name, NUM_BUFFER_SIZES, NUM_BAR_COUNTS);
+  report(&window_stats);
+  report(&power_stats);
+  report(&band_stats);
+  report(&db_stats);
+  report(&smooth_stats);
+  report(&downmix_stats);
+  report(&decimate_stats);
+
+  return window_stats.failures + power_stats.failures + band_stats.failures +
+         db_stats.failures + smooth_stats.failures + downmix_stats.failures +
+         decimate_stats.failures;
+}
+
+// Fixed-point engine against a double-precision DFT of the same window;
+// returns failure count
+static int check_fixed(check_buffers_t *b, int verbose) {
+  const int sample_rate = 44100;
+  const int bars = 64;
+  config_t config;
+  config_set_defaults(&config);
+  config.bar_count = bars;
+  float max_db = 0.0f;
+  long fixed_ns = 0;
+  int frames = 0;
+  int failures = 0;
+
+  // The DFT is quadratic, so only the smaller buffer sizes
+  for (int s = 0; s < NUM_BUFFER_SIZES && buffer_sizes[s] <= 2048; s++) {
+    int n = buffer_sizes[s];
+    int num_bins = n / 2 + 1;
+    fixed_context_t *fixed = fixed_init(sample_rate, n, &config);
+    if (!fixed)
+      return failures + 1;
+
+    dsp_hann_table(b->window, n);
+    dsp_bass_gain(b->gain, num_bins, config.bass_boost);
+    int used = dsp_build_bands(b->bands, bars, sample_rate, n,
+                               config.min_freq, config.max_freq);
+    for (int i = 0; i < n; i++) {
+      b->bins[2 * i] = cosf(2.0f * M_PI * i / n);
+      b->bins[2 * i + 1] = -sinf(2.0f * M_PI * i / n);
+    }
+
+    for (int kind = 0; kind < NUM_SIGNALS; kind++) {
+      make_signal(b->signal, n, kind);
+
+      long start_ns = now_ns();
+      fixed_process(fixed, b->signal, b->out_opt, bars);
+      fixed_ns += now_ns() - start_ns;
+      frames++;
+
+      for (int k = 0; k < used; k++) {
+        double re = 0.0, im = 0.0;
+        for (int i = 0; i < n; i++) {
+          double x = (double)b->signal[i] * b->window[i];
+          int t = (int)(((long)k * i) % n);
+          re += x * b->bins[2 * t];
+          im += x * b->bins[2 * t + 1];
+        }
+        b->power[k] = (float)(re * re + im * im) * b->gain[k];
+      }
+      dsp_bin_bands(b->power, b->bands, b->out_ref, bars);
+
+      float scale = 16.0f / ((float)n * n);
+      for (int i = 0; i < bars; i++) {
+        if (10.0f * log10f(b->out_ref[i] * scale + 1e-30f) <
+            config.db_floor)
+          continue;
+        float db = fabsf(10.0f * log10f(b->out_opt[i] / b->out_ref[i]));
+        if (db > max_db)
+          max_db = db;
+        if (db > TOL_FIXED_DB) {
+          failures++;
+          if (verbose)
+            printf("fixed: n=%d signal=%s bar=%d off by %.2f dB\n", n,
+                   signal_names[kind], i, db);
+          break;
+        }
+      }
+    }
+
+    fixed_cleanup(fixed);
+  }
+
+  printf("fixed-point engine vs double DFT (buffer sizes up to 2048):\n");
+  printf("  max %.2f dB above the floor  %.1f us per frame  %s\n", max_db,
+         frames ? fixed_ns / 1e3 / frames : 0.0, failures ? "FAIL" : "ok");
+  return failures;
+}
+
+// Run every supported kernel set against the reference; returns failures
+static int dsp_check(int verbose) {
+  check_buffers_t b = {
+      .signal = malloc(sizeof(float) * MAX_BUFFER),
+      .stereo = malloc(sizeof(float) * 2 * MAX_BUFFER),
+      .window = malloc(sizeof(float) * MAX_BUFFER),
+      .taps = malloc(sizeof(float) * DSP_MAX_TAPS),
+      .out_ref = malloc(sizeof(float) * MAX_BUFFER),
+      .out_opt = malloc(sizeof(float) * MAX_BUFFER),
+      .bins = malloc(sizeof(float) * 2 * (MAX_BUFFER / 2 + 1)),
+      .gain = malloc(sizeof(float) * (MAX_BUFFER / 2 + 1)),
+      .power = malloc(sizeof(float) * (MAX_BUFFER / 2 + 1)),
+      .state_ref = malloc(sizeof(float) * 3 * MAX_BARS),
+      .state_opt = malloc(sizeof(float) * 3 * MAX_BARS),
+      .bands = malloc(sizeof(dsp_band_t) * MAX_BARS),
+  };
+
+  int failures = 0;
+  if (!b.signal || !b.stereo || !b.window || !b.taps || !b.out_ref ||
+      !b.out_opt || !b.bins || !b.gain || !b.power || !b.state_ref ||
+      !b.state_opt || !b.bands) {
+    fprintf(stderr, "Failed to allocate DSP check buffers\n");
+    failures = 1;
+  } else {
+    // The scalar set is always supported and comes last
+    const dsp_kernels_t *scalar = dsp_variant(dsp_variant_count() - 1);
+    printf("Selected kernels: %s\n", dsp_isa());
+    for (int i = 0; i < dsp_variant_count(); i++)
+      failures += check_variant(dsp_variant(i), scalar, &b, verbose);
+    failures += check_fixed(&b, verbose);
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+  }
+
+  free(b.bands);
+  free(b.state_opt);
+  free(b.state_ref);
+  free(b.power);
+  free(b.gain);
+  free(b.bins);
+  free(b.out_opt);
+  free(b.out_ref);
+  free(b.taps);
+  free(b.window);
+  free(b.stereo);
+  free(b.signal);
+
+  return failures;
+}
+
+// DSP kernel check (make check), built apart from audiovis so the
+// reference kernels do not ship with it. An optional argument names the
+// kernel set reported as selected, like audiovis --isa.
+int main(int argc, char **argv) {
+  if (dsp_init(argc > 1 ? argv[1] : NULL) != 0)
+    return 1;
+  return dsp_check(1) ? 1 : 0;
+}
@@ -0,0 +1,164 @@
+#include "dsp.h"
+
+#if defined(__aarch64__)
+
+#include <arm_neon.h>
+
+// NEON is part of the AArch64 baseline, so no target attributes are
+// needed; vld2q de-interleaves complex bins and stereo frames directly.
+
+static void window_neon(const float *in, const float *window, float *out,
+                        int n) {
+  int i = 0;
+  for (; i + 4 <= n; i += 4)
+    vst1q_f32(out + i, vmulq_f32(vld1q_f32(in + i), vld1q_f32(window + i)));
+  for (; i < n; i++)
+    out[i] = in[i] * window[i];
+}
+
+static void power_neon(const float *bins, const float *gain, float *power,
+                       int n) {
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    float32x4x2_t c = vld2q_f32(bins + 2 * i);
+    float32x4_t sq = vaddq_f32(vmulq_f32(c.val[0], c.val[0]),
+                               vmulq_f32(c.val[1], c.val[1]));
+    vst1q_f32(power + i, vmulq_f32(sq, vld1q_f32(gain + i)));
+  }
+  for (; i < n; i++) {
+    float real = bins[2 * i];
+    float imag = bins[2 * i + 1];
+    power[i] = (real * real + imag * imag) * gain[i];
+  }
+}
+
+// Lane-wise dsp_fast_log2(), polynomial evaluated with FMA
+static float32x4_t log2_neon(float32x4_t x) {
+  uint32x4_t bits = vreinterpretq_u32_f32(x);
+  float32x4_t e = vcvtq_f32_s32(vsubq_s32(
+      vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), vdupq_n_s32(127)));
+  float32x4_t m = vreinterpretq_f32_u32(vorrq_u32(
+      vandq_u32(bits, vdupq_n_u32(0x007fffff)), vdupq_n_u32(0x3f800000)));
+  float32x4_t t = vsubq_f32(m, vdupq_n_f32(1.0f));
+  float32x4_t p = vdupq_n_f32(DSP_LOG2_C5);
+  p = vfmaq_f32(vdupq_n_f32(DSP_LOG2_C4), t, p);
+  p = vfmaq_f32(vdupq_n_f32(DSP_LOG2_C3), t, p);
+  p = vfmaq_f32(vdupq_n_f32(DSP_LOG2_C2), t, p);
+  p = vfmaq_f32(vdupq_n_f32(DSP_LOG2_C1), t, p);
+  return vfmaq_f32(e, t, p);
+}
+
+static void db_scale_neon(const float *power, float *out, int n, float offset,
+                          float inv_range) {
+  float32x4_t floor = vdupq_n_f32(DSP_POWER_FLOOR);
+  float32x4_t db = vdupq_n_f32(DSP_DB_PER_LOG2);
+  float32x4_t off = vdupq_n_f32(offset);
+  float32x4_t inv = vdupq_n_f32(inv_range);
+  float32x4_t zero = vdupq_n_f32(0.0f);
+  float32x4_t one = vdupq_n_f32(1.0f);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    float32x4_t p = vmaxq_f32(vld1q_f32(power + i), floor);
+    float32x4_t v = vmulq_f32(vfmaq_f32(off, db, log2_neon(p)), inv);
+    vst1q_f32(out + i, vminq_f32(vmaxq_f32(v, zero), one));
+  }
+  for (; i < n; i++) {
+    float p = power[i] > DSP_POWER_FLOOR ? power[i] : DSP_POWER_FLOOR;
+    float v = (DSP_DB_PER_LOG2 * dsp_fast_log2(p) + offset) * inv_range;
+    out[i] = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+  }
+}
+
+static void smooth_neon(float *state, float *peak, float *age,
+                        float *values, const dsp_smooth_t *p, int n) {
+  float32x4_t attack = vdupq_n_f32(p->attack);
+  float32x4_t release = vdupq_n_f32(p->release);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    float32x4_t s = vld1q_f32(state + i);
+    float32x4_t v = vld1q_f32(values + i);
+    float32x4_t a = vbslq_f32(vcgtq_f32(v, s), attack, release);
+    float32x4_t level = vaddq_f32(v, vmulq_f32(vsubq_f32(s, v), a));
+    vst1q_f32(state + i, level);
+    vst1q_f32(values + i, level);
+  }
+  for (; i < n; i++) {
+    float a = values[i] > state[i] ? p->attack : p->release;
+    float level = values[i] + (state[i] - values[i]) * a;
+    state[i] = level;
+    values[i] = level;
+  }
+
+  if (p->half_gravity <= 0.0f)
+    return;
+
+  float32x4_t hold = vdupq_n_f32(p->hold);
+  float32x4_t half_gravity = vdupq_n_f32(p->half_gravity);
+  float32x4_t dt = vdupq_n_f32(p->dt);
+  float32x4_t zero = vdupq_n_f32(0.0f);
+  for (i = 0; i + 4 <= n; i += 4) {
+    float32x4_t level = vld1q_f32(values + i);
+    float32x4_t pk = vld1q_f32(peak + i);
+    float32x4_t ag = vaddq_f32(vld1q_f32(age + i), dt);
+    float32x4_t t = vmaxq_f32(vsubq_f32(ag, hold), zero);
+    float32x4_t fall =
+        vsubq_f32(pk, vmulq_f32(vmulq_f32(half_gravity, t), t));
+    uint32x4_t up = vcgeq_f32(level, fall);
+    vst1q_f32(values + i, vbslq_f32(up, level, fall));
+    vst1q_f32(peak + i, vbslq_f32(up, level, pk));
+    vst1q_f32(age + i, vbslq_f32(up, zero, ag));
+  }
+  for (; i < n; i++) {
+    float since = age[i] + p->dt;
+    float t = since - p->hold;
+    t = t > 0.0f ? t : 0.0f;
+    float fall = peak[i] - p->half_gravity * t * t;
+    if (values[i] >= fall) {
+      peak[i] = values[i];
+      age[i] = 0.0f;
+    } else {
+      age[i] = since;
+      values[i] = fall;
+    }
+  }
+}
+
+static void downmix_neon(const float *in, float *out, int frames,
+                         int channels) {
+  if (channels != 2) {
+    dsp_downmix_scalar(in, out, frames, channels);
+    return;
+  }
+
+  float32x4_t half = vdupq_n_f32(0.5f);
+  int i = 0;
+  for (; i + 4 <= frames; i += 4) {
+    float32x4x2_t lr = vld2q_f32(in + 2 * i);
+    vst1q_f32(out + i, vmulq_f32(vaddq_f32(lr.val[0], lr.val[1]), half));
+  }
+  for (; i < frames; i++)
+    out[i] = (in[2 * i] + in[2 * i + 1]) * 0.5f;
+}
+
+// One dot product per output, vectorized over the taps
+static void decimate_neon(const float *in, const float *taps, int num_taps,
+                          int factor, float *out, int n) {
+  for (int i = 0; i < n; i++) {
+    const float *x = in + (long)i * factor;
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    int k = 0;
+    for (; k + 4 <= num_taps; k += 4)
+      acc = vfmaq_f32(acc, vld1q_f32(taps + k), vld1q_f32(x + k));
+    float sum = vaddvq_f32(acc);
+    for (; k < num_taps; k++)
+      sum += taps[k] * x[k];
+    out[i] = sum;
+  }
+}
+
+const dsp_kernels_t dsp_kernels_neon = {
+    "neon",      window_neon,  power_neon,    db_scale_neon,
+    smooth_neon, downmix_neon, decimate_neon,
+};
+
+#endif
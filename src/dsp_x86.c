@@ -0,0 +1,514 @@
+#include "dsp.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+// Each kernel handles full vectors and finishes the tail in scalar code.
+// Functions carry target attributes so the file builds with the default
+// flags and the variant is only called when the CPU supports it.
+
+// Scalar tails shared by all x86 variants
+static void window_tail(const float *in, const float *window, float *out,
+                        int i, int n) {
+  for (; i < n; i++)
+    out[i] = in[i] * window[i];
+}
+
+static void power_tail(const float *bins, const float *gain, float *power,
+                       int i, int n) {
+  for (; i < n; i++) {
+    float real = bins[2 * i];
+    float imag = bins[2 * i + 1];
+    power[i] = (real * real + imag * imag) * gain[i];
+  }
+}
+
+static void db_scale_tail(const float *power, float *out, float offset,
+                          float inv_range, int i, int n) {
+  for (; i < n; i++) {
+    float p = power[i] > DSP_POWER_FLOOR ? power[i] : DSP_POWER_FLOOR;
+    float v = (DSP_DB_PER_LOG2 * dsp_fast_log2(p) + offset) * inv_range;
+    out[i] = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+  }
+}
+
+static void smooth_tail(float *state, float *values, const dsp_smooth_t *p,
+                        int i, int n) {
+  for (; i < n; i++) {
+    float a = values[i] > state[i] ? p->attack : p->release;
+    float level = values[i] + (state[i] - values[i]) * a;
+    state[i] = level;
+    values[i] = level;
+  }
+}
+
+static void peak_tail(float *peak, float *age, float *values,
+                      const dsp_smooth_t *p, int i, int n) {
+  for (; i < n; i++) {
+    float since = age[i] + p->dt;
+    float t = since - p->hold;
+    t = t > 0.0f ? t : 0.0f;
+    float fall = peak[i] - p->half_gravity * t * t;
+    if (values[i] >= fall) {
+      peak[i] = values[i];
+      age[i] = 0.0f;
+    } else {
+      age[i] = since;
+      values[i] = fall;
+    }
+  }
+}
+
+static void downmix_tail(const float *in, float *out, int i, int frames) {
+  for (; i < frames; i++)
+    out[i] = (in[2 * i] + in[2 * i + 1]) * 0.5f;
+}
+
+// Remaining taps of one decimated output
+static float decimate_tail(const float *x, const float *taps, int k,
+                           int num_taps) {
+  float sum = 0.0f;
+  for (; k < num_taps; k++)
+    sum += taps[k] * x[k];
+  return sum;
+}
+
+// Sum of the four lanes
+__attribute__((target("sse2"))) static inline float hsum_sse2(__m128 v) {
+  __m128 pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+  return _mm_cvtss_f32(
+      _mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1))));
+}
+
+/* SSE2 */
+
+__attribute__((target("sse2"))) static void
+window_sse2(const float *in, const float *window, float *out, int n) {
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128 v = _mm_mul_ps(_mm_loadu_ps(in + i), _mm_loadu_ps(window + i));
+    _mm_storeu_ps(out + i, v);
+  }
+  window_tail(in, window, out, i, n);
+}
+
+__attribute__((target("sse2"))) static void
+power_sse2(const float *bins, const float *gain, float *power, int n) {
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128 a = _mm_loadu_ps(bins + 2 * i);
+    __m128 b = _mm_loadu_ps(bins + 2 * i + 4);
+    __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    __m128 sq = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+    _mm_storeu_ps(power + i, _mm_mul_ps(sq, _mm_loadu_ps(gain + i)));
+  }
+  power_tail(bins, gain, power, i, n);
+}
+
+// Lane-wise dsp_fast_log2()
+__attribute__((target("sse2"))) static __m128 log2_sse2(__m128 x) {
+  __m128i bits = _mm_castps_si128(x);
+  __m128 e = _mm_cvtepi32_ps(
+      _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+  __m128 m = _mm_castsi128_ps(
+      _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)),
+                   _mm_set1_epi32(0x3f800000)));
+  __m128 t = _mm_sub_ps(m, _mm_set1_ps(1.0f));
+  __m128 p = _mm_set1_ps(DSP_LOG2_C5);
+  p = _mm_add_ps(_mm_set1_ps(DSP_LOG2_C4), _mm_mul_ps(t, p));
+  p = _mm_add_ps(_mm_set1_ps(DSP_LOG2_C3), _mm_mul_ps(t, p));
+  p = _mm_add_ps(_mm_set1_ps(DSP_LOG2_C2), _mm_mul_ps(t, p));
+  p = _mm_add_ps(_mm_set1_ps(DSP_LOG2_C1), _mm_mul_ps(t, p));
+  return _mm_add_ps(e, _mm_mul_ps(t, p));
+}
+
+__attribute__((target("sse2"))) static void
+db_scale_sse2(const float *power, float *out, int n, float offset,
+              float inv_range) {
+  __m128 floor = _mm_set1_ps(DSP_POWER_FLOOR);
+  __m128 db = _mm_set1_ps(DSP_DB_PER_LOG2);
+  __m128 off = _mm_set1_ps(offset);
+  __m128 inv = _mm_set1_ps(inv_range);
+  __m128 zero = _mm_setzero_ps();
+  __m128 one = _mm_set1_ps(1.0f);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128 p = _mm_max_ps(_mm_loadu_ps(power + i), floor);
+    __m128 v = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(db, log2_sse2(p)), off), inv);
+    _mm_storeu_ps(out + i, _mm_min_ps(_mm_max_ps(v, zero), one));
+  }
+  db_scale_tail(power, out, offset, inv_range, i, n);
+}
+
+__attribute__((target("sse2"))) static void
+smooth_sse2(float *state, float *peak, float *age, float *values,
+            const dsp_smooth_t *p, int n) {
+  __m128 attack = _mm_set1_ps(p->attack);
+  __m128 release = _mm_set1_ps(p->release);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128 s = _mm_loadu_ps(state + i);
+    __m128 v = _mm_loadu_ps(values + i);
+    __m128 rising = _mm_cmpgt_ps(v, s);
+    __m128 a = _mm_or_ps(_mm_and_ps(rising, attack),
+                         _mm_andnot_ps(rising, release));
+    __m128 level = _mm_add_ps(v, _mm_mul_ps(_mm_sub_ps(s, v), a));
+    _mm_storeu_ps(state + i, level);
+    _mm_storeu_ps(values + i, level);
+  }
+  smooth_tail(state, values, p, i, n);
+
+  if (p->half_gravity <= 0.0f)
+    return;
+
+  __m128 hold = _mm_set1_ps(p->hold);
+  __m128 half_gravity = _mm_set1_ps(p->half_gravity);
+  __m128 dt = _mm_set1_ps(p->dt);
+  __m128 zero = _mm_setzero_ps();
+  for (i = 0; i + 4 <= n; i += 4) {
+    __m128 level = _mm_loadu_ps(values + i);
+    __m128 pk = _mm_loadu_ps(peak + i);
+    __m128 ag = _mm_add_ps(_mm_loadu_ps(age + i), dt);
+    __m128 t = _mm_max_ps(_mm_sub_ps(ag, hold), zero);
+    __m128 fall = _mm_sub_ps(pk, _mm_mul_ps(_mm_mul_ps(half_gravity, t), t));
+    __m128 up = _mm_cmpge_ps(level, fall);
+    _mm_storeu_ps(values + i, _mm_max_ps(level, fall));
+    _mm_storeu_ps(peak + i,
+                  _mm_or_ps(_mm_and_ps(up, level), _mm_andnot_ps(up, pk)));
+    _mm_storeu_ps(age + i, _mm_andnot_ps(up, ag));
+  }
+  peak_tail(peak, age, values, p, i, n);
+}
+
+__attribute__((target("sse2"))) static void
+downmix_sse2(const float *in, float *out, int frames, int channels) {
+  if (channels != 2) {
+    dsp_downmix_scalar(in, out, frames, channels);
+    return;
+  }
+
+  __m128 half = _mm_set1_ps(0.5f);
+  int i = 0;
+  for (; i + 4 <= frames; i += 4) {
+    __m128 a = _mm_loadu_ps(in + 2 * i);
+    __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+    __m128 l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_add_ps(l, r), half));
+  }
+  downmix_tail(in, out, i, frames);
+}
+
+// One dot product per output, vectorized over the taps
+__attribute__((target("sse2"))) static void
+decimate_sse2(const float *in, const float *taps, int num_taps, int factor,
+              float *out, int n) {
+  for (int i = 0; i < n; i++) {
+    const float *x = in + (long)i * factor;
+    __m128 acc = _mm_setzero_ps();
+    int k = 0;
+    for (; k + 4 <= num_taps; k += 4)
+      acc = _mm_add_ps(acc,
+                       _mm_mul_ps(_mm_loadu_ps(taps + k), _mm_loadu_ps(x + k)));
+    out[i] = hsum_sse2(acc) + decimate_tail(x, taps, k, num_taps);
+  }
+}
+
+const dsp_kernels_t dsp_kernels_sse2 = {
+    "sse2",      window_sse2,  power_sse2,    db_scale_sse2,
+    smooth_sse2, downmix_sse2, decimate_sse2,
+};
+
+/* AVX2 + FMA */
+
+__attribute__((target("avx2,fma"))) static void
+window_avx2(const float *in, const float *window, float *out, int n) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 v =
+        _mm256_mul_ps(_mm256_loadu_ps(in + i), _mm256_loadu_ps(window + i));
+    _mm256_storeu_ps(out + i, v);
+  }
+  window_tail(in, window, out, i, n);
+}
+
+__attribute__((target("avx2,fma"))) static void
+power_avx2(const float *bins, const float *gain, float *power, int n) {
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 a = _mm256_loadu_ps(bins + 2 * i);
+    __m256 b = _mm256_loadu_ps(bins + 2 * i + 8);
+    // hadd pairs re^2 + im^2 within lanes; permute restores bin order
+    __m256 sq = _mm256_hadd_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b));
+    sq = _mm256_castpd_ps(
+        _mm256_permute4x64_pd(_mm256_castps_pd(sq), _MM_SHUFFLE(3, 1, 2, 0)));
+    _mm256_storeu_ps(power + i, _mm256_mul_ps(sq, _mm256_loadu_ps(gain + i)));
+  }
+  power_tail(bins, gain, power, i, n);
+}
+
+// Lane-wise dsp_fast_log2(), polynomial evaluated with FMA
+__attribute__((target("avx2,fma"))) static __m256 log2_avx2(__m256 x) {
+  __m256i bits = _mm256_castps_si256(x);
+  __m256 e = _mm256_cvtepi32_ps(
+      _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+  __m256 m = _mm256_castsi256_ps(
+      _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)),
+                      _mm256_set1_epi32(0x3f800000)));
+  __m256 t = _mm256_sub_ps(m, _mm256_set1_ps(1.0f));
+  __m256 p = _mm256_set1_ps(DSP_LOG2_C5);
+  p = _mm256_fmadd_ps(t, p, _mm256_set1_ps(DSP_LOG2_C4));
+  p = _mm256_fmadd_ps(t, p, _mm256_set1_ps(DSP_LOG2_C3));
+  p = _mm256_fmadd_ps(t, p, _mm256_set1_ps(DSP_LOG2_C2));
+  p = _mm256_fmadd_ps(t, p, _mm256_set1_ps(DSP_LOG2_C1));
+  return _mm256_fmadd_ps(t, p, e);
+}
+
+__attribute__((target("avx2,fma"))) static void
+db_scale_avx2(const float *power, float *out, int n, float offset,
+              float inv_range) {
+  __m256 floor = _mm256_set1_ps(DSP_POWER_FLOOR);
+  __m256 db = _mm256_set1_ps(DSP_DB_PER_LOG2);
+  __m256 off = _mm256_set1_ps(offset);
+  __m256 inv = _mm256_set1_ps(inv_range);
+  __m256 zero = _mm256_setzero_ps();
+  __m256 one = _mm256_set1_ps(1.0f);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 p = _mm256_max_ps(_mm256_loadu_ps(power + i), floor);
+    __m256 v = _mm256_mul_ps(_mm256_fmadd_ps(db, log2_avx2(p), off), inv);
+    _mm256_storeu_ps(out + i, _mm256_min_ps(_mm256_max_ps(v, zero), one));
+  }
+  db_scale_tail(power, out, offset, inv_range, i, n);
+}
+
+__attribute__((target("avx2,fma"))) static void
+smooth_avx2(float *state, float *peak, float *age, float *values,
+            const dsp_smooth_t *p, int n) {
+  __m256 attack = _mm256_set1_ps(p->attack);
+  __m256 release = _mm256_set1_ps(p->release);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 s = _mm256_loadu_ps(state + i);
+    __m256 v = _mm256_loadu_ps(values + i);
+    __m256 rising = _mm256_cmp_ps(v, s, _CMP_GT_OQ);
+    __m256 a = _mm256_blendv_ps(release, attack, rising);
+    __m256 level = _mm256_add_ps(v, _mm256_mul_ps(_mm256_sub_ps(s, v), a));
+    _mm256_storeu_ps(state + i, level);
+    _mm256_storeu_ps(values + i, level);
+  }
+  smooth_tail(state, values, p, i, n);
+
+  if (p->half_gravity <= 0.0f)
+    return;
+
+  __m256 hold = _mm256_set1_ps(p->hold);
+  __m256 half_gravity = _mm256_set1_ps(p->half_gravity);
+  __m256 dt = _mm256_set1_ps(p->dt);
+  __m256 zero = _mm256_setzero_ps();
+  for (i = 0; i + 8 <= n; i += 8) {
+    __m256 level = _mm256_loadu_ps(values + i);
+    __m256 pk = _mm256_loadu_ps(peak + i);
+    __m256 ag = _mm256_add_ps(_mm256_loadu_ps(age + i), dt);
+    __m256 t = _mm256_max_ps(_mm256_sub_ps(ag, hold), zero);
+    __m256 fall =
+        _mm256_sub_ps(pk, _mm256_mul_ps(_mm256_mul_ps(half_gravity, t), t));
+    __m256 up = _mm256_cmp_ps(level, fall, _CMP_GE_OQ);
+    _mm256_storeu_ps(values + i, _mm256_max_ps(level, fall));
+    _mm256_storeu_ps(peak + i, _mm256_blendv_ps(pk, level, up));
+    _mm256_storeu_ps(age + i, _mm256_andnot_ps(up, ag));
+  }
+  peak_tail(peak, age, values, p, i, n);
+}
+
+__attribute__((target("avx2,fma"))) static void
+downmix_avx2(const float *in, float *out, int frames, int channels) {
+  if (channels != 2) {
+    dsp_downmix_scalar(in, out, frames, channels);
+    return;
+  }
+
+  __m256 half = _mm256_set1_ps(0.5f);
+  int i = 0;
+  for (; i + 8 <= frames; i += 8) {
+    __m256 a = _mm256_loadu_ps(in + 2 * i);
+    __m256 b = _mm256_loadu_ps(in + 2 * i + 8);
+    __m256 sum = _mm256_hadd_ps(a, b);
+    sum = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sum),
+                                                 _MM_SHUFFLE(3, 1, 2, 0)));
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(sum, half));
+  }
+  downmix_tail(in, out, i, frames);
+}
+
+__attribute__((target("avx2,fma"))) static void
+decimate_avx2(const float *in, const float *taps, int num_taps, int factor,
+              float *out, int n) {
+  for (int i = 0; i < n; i++) {
+    const float *x = in + (long)i * factor;
+    __m256 acc = _mm256_setzero_ps();
+    int k = 0;
+    for (; k + 8 <= num_taps; k += 8)
+      acc = _mm256_fmadd_ps(_mm256_loadu_ps(taps + k), _mm256_loadu_ps(x + k),
+                            acc);
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc),
+                             _mm256_extractf128_ps(acc, 1));
+    out[i] = hsum_sse2(half) + decimate_tail(x, taps, k, num_taps);
+  }
+}
+
+const dsp_kernels_t dsp_kernels_avx2 = {
+    "avx2",      window_avx2,  power_avx2,    db_scale_avx2,
+    smooth_avx2, downmix_avx2, decimate_avx2,
+};
+
+/* AVX-512F */
+
+__attribute__((target("avx512f"))) static void
+window_avx512(const float *in, const float *window, float *out, int n) {
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512 v =
+        _mm512_mul_ps(_mm512_loadu_ps(in + i), _mm512_loadu_ps(window + i));
+    _mm512_storeu_ps(out + i, v);
+  }
+  window_tail(in, window, out, i, n);
+}
+
+__attribute__((target("avx512f"))) static void
+power_avx512(const float *bins, const float *gain, float *power, int n) {
+  const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18,
+                                         20, 22, 24, 26, 28, 30);
+  const __m512i odd = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19,
+                                        21, 23, 25, 27, 29, 31);
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512 a = _mm512_loadu_ps(bins + 2 * i);
+    __m512 b = _mm512_loadu_ps(bins + 2 * i + 16);
+    __m512 re = _mm512_permutex2var_ps(a, even, b);
+    __m512 im = _mm512_permutex2var_ps(a, odd, b);
+    __m512 sq = _mm512_fmadd_ps(re, re, _mm512_mul_ps(im, im));
+    _mm512_storeu_ps(power + i, _mm512_mul_ps(sq, _mm512_loadu_ps(gain + i)));
+  }
+  power_tail(bins, gain, power, i, n);
+}
+
+// Lane-wise dsp_fast_log2(), polynomial evaluated with FMA
+__attribute__((target("avx512f"))) static __m512 log2_avx512(__m512 x) {
+  __m512i bits = _mm512_castps_si512(x);
+  __m512 e = _mm512_cvtepi32_ps(
+      _mm512_sub_epi32(_mm512_srli_epi32(bits, 23), _mm512_set1_epi32(127)));
+  __m512 m = _mm512_castsi512_ps(
+      _mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi32(0x007fffff)),
+                      _mm512_set1_epi32(0x3f800000)));
+  __m512 t = _mm512_sub_ps(m, _mm512_set1_ps(1.0f));
+  __m512 p = _mm512_set1_ps(DSP_LOG2_C5);
+  p = _mm512_fmadd_ps(t, p, _mm512_set1_ps(DSP_LOG2_C4));
+  p = _mm512_fmadd_ps(t, p, _mm512_set1_ps(DSP_LOG2_C3));
+  p = _mm512_fmadd_ps(t, p, _mm512_set1_ps(DSP_LOG2_C2));
+  p = _mm512_fmadd_ps(t, p, _mm512_set1_ps(DSP_LOG2_C1));
+  return _mm512_fmadd_ps(t, p, e);
+}
+
+__attribute__((target("avx512f"))) static void
+db_scale_avx512(const float *power, float *out, int n, float offset,
+                float inv_range) {
+  __m512 floor = _mm512_set1_ps(DSP_POWER_FLOOR);
+  __m512 db = _mm512_set1_ps(DSP_DB_PER_LOG2);
+  __m512 off = _mm512_set1_ps(offset);
+  __m512 inv = _mm512_set1_ps(inv_range);
+  __m512 zero = _mm512_setzero_ps();
+  __m512 one = _mm512_set1_ps(1.0f);
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512 p = _mm512_max_ps(_mm512_loadu_ps(power + i), floor);
+    __m512 v = _mm512_mul_ps(_mm512_fmadd_ps(db, log2_avx512(p), off), inv);
+    _mm512_storeu_ps(out + i, _mm512_min_ps(_mm512_max_ps(v, zero), one));
+  }
+  db_scale_tail(power, out, offset, inv_range, i, n);
+}
+
+__attribute__((target("avx512f"))) static void
+smooth_avx512(float *state, float *peak, float *age, float *values,
+              const dsp_smooth_t *p, int n) {
+  __m512 attack = _mm512_set1_ps(p->attack);
+  __m512 release = _mm512_set1_ps(p->release);
+  int i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512 s = _mm512_loadu_ps(state + i);
+    __m512 v = _mm512_loadu_ps(values + i);
+    __mmask16 rising = _mm512_cmp_ps_mask(v, s, _CMP_GT_OQ);
+    __m512 a = _mm512_mask_blend_ps(rising, release, attack);
+    __m512 level = _mm512_add_ps(v, _mm512_mul_ps(_mm512_sub_ps(s, v), a));
+    _mm512_storeu_ps(state + i, level);
+    _mm512_storeu_ps(values + i, level);
+  }
+  smooth_tail(state, values, p, i, n);
+
+  if (p->half_gravity <= 0.0f)
+    return;
+
+  __m512 hold = _mm512_set1_ps(p->hold);
+  __m512 half_gravity = _mm512_set1_ps(p->half_gravity);
+  __m512 dt = _mm512_set1_ps(p->dt);
+  __m512 zero = _mm512_setzero_ps();
+  for (i = 0; i + 16 <= n; i += 16) {
+    __m512 level = _mm512_loadu_ps(values + i);
+    __m512 pk = _mm512_loadu_ps(peak + i);
+    __m512 ag = _mm512_add_ps(_mm512_loadu_ps(age + i), dt);
+    __m512 t = _mm512_max_ps(_mm512_sub_ps(ag, hold), zero);
+    __m512 fall =
+        _mm512_sub_ps(pk, _mm512_mul_ps(_mm512_mul_ps(half_gravity, t), t));
+    __mmask16 up = _mm512_cmp_ps_mask(level, fall, _CMP_GE_OQ);
+    _mm512_storeu_ps(values + i, _mm512_mask_blend_ps(up, fall, level));
+    _mm512_storeu_ps(peak + i, _mm512_mask_blend_ps(up, pk, level));
+    _mm512_storeu_ps(age + i, _mm512_mask_blend_ps(up, ag, zero));
+  }
+  peak_tail(peak, age, values, p, i, n);
+}
+
+__attribute__((target("avx512f"))) static void
+downmix_avx512(const float *in, float *out, int frames, int channels) {
+  if (channels != 2) {
+    dsp_downmix_scalar(in, out, frames, channels);
+    return;
+  }
+
+  const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18,
+                                         20, 22, 24, 26, 28, 30);
+  const __m512i odd = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19,
+                                        21, 23, 25, 27, 29, 31);
+  __m512 half = _mm512_set1_ps(0.5f);
+  int i = 0;
+  for (; i + 16 <= frames; i += 16) {
+    __m512 a = _mm512_loadu_ps(in + 2 * i);
+    __m512 b = _mm512_loadu_ps(in + 2 * i + 16);
+    __m512 l = _mm512_permutex2var_ps(a, even, b);
+    __m512 r = _mm512_permutex2var_ps(a, odd, b);
+    _mm512_storeu_ps(out + i, _mm512_mul_ps(_mm512_add_ps(l, r), half));
+  }
+  downmix_tail(in, out, i, frames);
+}
+
+__attribute__((target("avx512f"))) static void
+decimate_avx512(const float *in, const float *taps, int num_taps, int factor,
+                float *out, int n) {
+  for (int i = 0; i < n; i++) {
+    const float *x = in + (long)i * factor;
+    __m512 acc = _mm512_setzero_ps();
+    int k = 0;
+    for (; k + 16 <= num_taps; k += 16)
+      acc = _mm512_fmadd_ps(_mm512_loadu_ps(taps + k), _mm512_loadu_ps(x + k),
+                            acc);
+    out[i] = _mm512_reduce_add_ps(acc) + decimate_tail(x, taps, k, num_taps);
+  }
+}
+
+const dsp_kernels_t dsp_kernels_avx512 = {
+    "avx512",      window_avx512,  power_avx512,    db_scale_avx512,
+    smooth_avx512, downmix_avx512, decimate_avx512,
+};
+
+#endif
@@ -1,36 +1,158 @@
 #include "fft.h"
+#include "agc.h"
+#include "dsp.h"
+#include "fixed.h"
+#include "sdft.h"
+#include "trace.h"
 #include "utils.h"
 #include <fftw3.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+// FFTW's planner is not thread-safe: every plan creation and destruction
+// (from any context or planner thread) holds this lock
+static pthread_mutex_t planner_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Input samples filtered per decimation step (a multiple of every factor)
+#define STAGE_CHUNK 1024
+
 // FFT context structure
 struct fft_context {
   int sample_rate;
   int buffer_size;
-
-  // FFTW3 structures
-  fftwf_plan plan;
+  int engine; // ENGINE_FFT or ENGINE_SDFT
+
+  // Decimation ahead of the FFT when max_freq is well below Nyquist: the
+  // FFT runs on fft_size = buffer_size / decimation samples at the reduced
+  // rate, so bins keep their spacing. Samples from fft_push() are filtered
+  // as they arrive into a mirrored history of the decimated signal (each
+  // output at pos and pos + fft_size); until that holds a full window, or
+  // for callers that never push, fft_process() filters its window instead.
+  int decimation; // 1 = none
+  int fft_size;
+  float *taps;
+  int num_taps;
+  float *stage; // Input not yet consumed by the filter
+  int staged;
+  float *history;
+  int history_pos;
+  long decimated; // Outputs written to the history
+
+  // Sliding DFT bank (ENGINE_SDFT only)
+  sdft_context_t *sdft;
+
+  // Fixed-point pipeline (ENGINE_FIXED only)
+  fixed_context_t *fixed;
+
+  // FFTW3 structures. Startup uses an FFTW_ESTIMATE plan while a planner
+  // thread measures a faster one; fft_process() switches between frames.
+  fftwf_plan plan;          // Plan executed by fft_process()
+  fftwf_plan estimate_plan; // Kept until cleanup once replaced
+  fftwf_plan measured_plan; // Published by the planner thread (atomic)
+  pthread_t planner;
+  int planner_started;
   float *input;
   fftwf_complex *output;
 
+  // Precomputed tables for the DSP kernels
+  float *window;
+  float *bin_gain;
+  float *bin_power;
+  dsp_band_t *bands;
+  int used_bins;
+
+  // dB mapping folded into db_scale kernel parameters
+  float db_offset;
+  float db_inv_range;
+  float db_level; // dB full scale of bar power 1
+
+  // Automatic gain control (NULL when off); its gain shifts db_offset
+  agc_t *agc;
+
   // Configuration
   float sensitivity;
-  float smoothing;
+  float attack_ms;
+  float release_ms;
+  float hold_ms;
+  float gravity;
   float bass_boost;
   int min_freq;
   int max_freq;
 
-  // Smoothing buffers
+  // Smoothing buffers: levels, held peaks and their ages (one block)
   float *prev_magnitudes;
+  float *peaks;
+  float *peak_age;
   int num_bars;
+  long last_ns; // Time of the previous analysis (0 = none yet)
 };
 
-// Initialize FFT processing
-fft_context_t *fft_init(int sample_rate, int buffer_size,
-                        const config_t *config) {
+// Rough per-frame cost of windowing, FFT and per-bin power
+static float fft_cost(int buffer_size) {
+  return 3.0f * buffer_size * log2f((float)buffer_size) + 10.0f * buffer_size;
+}
+
+// Pick the cheaper floating-point engine for the configured bars, buffer
+// size and hop (samples between analyses, which run at analysis_rate or
+// else fps); the fixed-point engine is only used when asked for
+static int select_engine(int sample_rate, int buffer_size,
+                         const config_t *config) {
+  if (config->engine == ENGINE_FFT || config->engine == ENGINE_SDFT ||
+      config->engine == ENGINE_FIXED)
+    return config->engine;
+
+  int rate = config->analysis_rate > 0 ? config->analysis_rate : config->fps;
+  int hop = sample_rate / (rate > 0 ? rate : 60);
+  if (sdft_cost(config->bar_count, hop) < fft_cost(buffer_size))
+    return ENGINE_SDFT;
+  return ENGINE_FFT;
+}
+
+// Power of a full-scale sine relative to one Hann-windowed bin: the peak
+// bin magnitude is N/4, so 16 / N^2 puts it at 0 dB. Sensitivity is an
+// amplitude gain and enters squared.
+static float db_scale_factor(int buffer_size, float sensitivity) {
+  float n = (float)buffer_size;
+  return 16.0f / (n * n) * sensitivity * sensitivity;
+}
+
+// Planner thread: FFTW_MEASURE overwrites its arrays, so measure on
+// scratch buffers (fftwf_malloc gives them the same alignment) and run
+// the plan on the real ones with the new-array execute interface
+static void *measure_plan(void *data) {
+  fft_context_t *ctx = data;
+  int num_bins = ctx->fft_size / 2 + 1;
+  float *in = fftwf_malloc(sizeof(float) * ctx->fft_size);
+  fftwf_complex *out = fftwf_malloc(sizeof(fftwf_complex) * num_bins);
+  fftwf_plan plan = NULL;
+
+  trace_thread_name("fft planner");
+  long trace_start = trace_begin();
+  if (in && out) {
+    pthread_mutex_lock(&planner_lock);
+    plan = fftwf_plan_dft_r2c_1d(ctx->fft_size, in, out, FFTW_MEASURE);
+    pthread_mutex_unlock(&planner_lock);
+  }
+  trace_end("fft_plan_measure", trace_start);
+
+  if (in)
+    fftwf_free(in);
+  if (out)
+    fftwf_free(out);
+
+  // Keep the estimate plan if measuring failed
+  if (plan)
+    __atomic_store_n(&ctx->measured_plan, plan, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+// Set up the selected engine; with measure, a planner thread then looks
+// for a faster FFT plan than the estimated one
+static fft_context_t *create_context(int sample_rate, int buffer_size,
+                                     const config_t *config, int measure) {
   fft_context_t *ctx = calloc(1, sizeof(fft_context_t));
   if (!ctx) {
     fprintf(stderr, "Failed to allocate FFT context\n");
@@ -40,127 +162,317 @@ fft_context_t *fft_init(int sample_rate, int buffer_size,
   ctx->sample_rate = sample_rate;
   ctx->buffer_size = buffer_size;
   ctx->sensitivity = config->sensitivity;
-  ctx->smoothing = config->smoothing;
+  ctx->attack_ms = config->attack_ms;
+  ctx->release_ms = config->release_ms;
+  ctx->hold_ms = config->peak_hold_ms;
+  ctx->gravity = config->gravity;
   ctx->bass_boost = config->bass_boost;
   ctx->min_freq = config->min_freq;
   ctx->max_freq = config->max_freq;
   ctx->num_bars = config->bar_count;
+  ctx->decimation = dsp_decimation(sample_rate, buffer_size, config->max_freq);
+  ctx->fft_size = buffer_size / ctx->decimation;
+  ctx->engine = select_engine(sample_rate, ctx->fft_size, config);
+  if (ctx->engine != ENGINE_FFT) {
+    ctx->decimation = 1;
+    ctx->fft_size = buffer_size;
+  }
+  float scale = db_scale_factor(ctx->fft_size, config->sensitivity);
+  dsp_db_params(scale, config->db_floor, config->db_ceiling, &ctx->db_offset,
+                &ctx->db_inv_range);
+  ctx->db_level = DSP_DB_PER_LOG2 * log2f(scale);
+
+  if (config->agc) {
+    ctx->agc = agc_init(config->agc_window, config->db_floor,
+                        config->db_ceiling);
+    if (!ctx->agc) {
+      fft_cleanup(ctx);
+      return NULL;
+    }
+  }
 
-  // Allocate FFTW buffers
-  ctx->input = fftwf_malloc(sizeof(float) * buffer_size);
-  ctx->output = fftwf_malloc(sizeof(fftwf_complex) * (buffer_size / 2 + 1));
+  // Allocate smoothing buffers
+  ctx->prev_magnitudes = calloc(3 * config->bar_count, sizeof(float));
+  if (!ctx->prev_magnitudes) {
+    fprintf(stderr, "Failed to allocate smoothing buffer\n");
+    fft_cleanup(ctx);
+    return NULL;
+  }
+  ctx->peaks = ctx->prev_magnitudes + config->bar_count;
+  ctx->peak_age = ctx->peaks + config->bar_count;
+
+  if (ctx->engine == ENGINE_SDFT) {
+    ctx->sdft = sdft_init(sample_rate, buffer_size, config);
+    if (!ctx->sdft) {
+      fft_cleanup(ctx);
+      return NULL;
+    }
+    return ctx;
+  }
+
+  if (ctx->engine == ENGINE_FIXED) {
+    ctx->fixed = fixed_init(sample_rate, buffer_size, config);
+    if (!ctx->fixed) {
+      fft_cleanup(ctx);
+      return NULL;
+    }
+    return ctx;
+  }
 
-  if (!ctx->input || !ctx->output) {
+  // Allocate FFTW buffers
+  int fft_size = ctx->fft_size;
+  int num_bins = fft_size / 2 + 1;
+  ctx->input = fftwf_malloc(sizeof(float) * fft_size);
+  ctx->output = fftwf_malloc(sizeof(fftwf_complex) * num_bins);
+
+  // Precomputed window, bass gain and bar-to-bin map. Decimated bins keep
+  // the full-rate spacing, and max_freq is below the decimated Nyquist
+  // frequency, so the map and bass range are those of the full-rate FFT.
+  ctx->window = malloc(sizeof(float) * fft_size);
+  ctx->bin_gain = malloc(sizeof(float) * (buffer_size / 2 + 1));
+  ctx->bin_power = malloc(sizeof(float) * num_bins);
+  ctx->bands = malloc(sizeof(dsp_band_t) * config->bar_count);
+
+  if (!ctx->input || !ctx->output || !ctx->window || !ctx->bin_gain ||
+      !ctx->bin_power || !ctx->bands) {
     fprintf(stderr, "Failed to allocate FFT buffers\n");
-    if (ctx->input)
-      fftwf_free(ctx->input);
-    if (ctx->output)
-      fftwf_free(ctx->output);
-    free(ctx);
+    fft_cleanup(ctx);
     return NULL;
   }
 
-  // Create FFT plan
-  ctx->plan =
-      fftwf_plan_dft_r2c_1d(buffer_size, ctx->input, ctx->output, FFTW_MEASURE);
-  if (!ctx->plan) {
+  dsp_hann_table(ctx->window, fft_size);
+  dsp_bass_gain(ctx->bin_gain, buffer_size / 2 + 1, ctx->bass_boost);
+  ctx->used_bins =
+      dsp_build_bands(ctx->bands, config->bar_count, sample_rate, buffer_size,
+                      config->min_freq, config->max_freq);
+
+  // Anti-alias filter and decimation buffers
+  if (ctx->decimation > 1) {
+    ctx->num_taps =
+        dsp_lowpass_taps(sample_rate, ctx->decimation, config->max_freq);
+    ctx->taps = malloc(sizeof(float) * ctx->num_taps);
+    ctx->stage = malloc(sizeof(float) * (ctx->num_taps + STAGE_CHUNK));
+    ctx->history = calloc(2 * fft_size, sizeof(float));
+    if (!ctx->taps || !ctx->stage || !ctx->history) {
+      fprintf(stderr, "Failed to allocate decimation buffers\n");
+      fft_cleanup(ctx);
+      return NULL;
+    }
+    dsp_lowpass_table(ctx->taps, ctx->num_taps, ctx->decimation);
+  }
+
+  // Create a plan instantly (FFTW_ESTIMATE does not touch the arrays) so
+  // the first frame renders right away
+  long trace_start = trace_begin();
+  pthread_mutex_lock(&planner_lock);
+  ctx->estimate_plan = fftwf_plan_dft_r2c_1d(fft_size, ctx->input,
+                                             ctx->output, FFTW_ESTIMATE);
+  pthread_mutex_unlock(&planner_lock);
+  trace_end("fft_plan_estimate", trace_start);
+  if (!ctx->estimate_plan) {
     fprintf(stderr, "Failed to create FFT plan\n");
-    fftwf_free(ctx->input);
-    fftwf_free(ctx->output);
-    free(ctx);
+    fft_cleanup(ctx);
     return NULL;
   }
+  ctx->plan = ctx->estimate_plan;
+  if (!measure)
+    return ctx;
 
-  // Allocate smoothing buffer
-  ctx->prev_magnitudes = calloc(config->bar_count, sizeof(float));
+  // Measure the optimized plan while capture and the renderer start up
+  if (pthread_create(&ctx->planner, NULL, measure_plan, ctx) == 0)
+    ctx->planner_started = 1;
+  else
+    fprintf(stderr, "Failed to start FFT planner, using estimated plan\n");
 
   return ctx;
 }
 
-// Process audio buffer and generate frequency magnitudes
+// Initialize FFT processing
+fft_context_t *fft_init(int sample_rate, int buffer_size,
+                        const config_t *config) {
+  return create_context(sample_rate, buffer_size, config, 1);
+}
+
+// Initialize FFT processing that always runs the FFTW_ESTIMATE plan: the
+// plan depends only on the size, never on timing, so results are the
+// same on every run and thread count
+fft_context_t *fft_init_estimate(int sample_rate, int buffer_size,
+                                 const config_t *config) {
+  return create_context(sample_rate, buffer_size, config, 0);
+}
+
+// Block until the measured plan is in use, so every following frame runs
+// the same plan (batch analysis wants output independent of timing)
+void fft_wait_plan(fft_context_t *ctx) {
+  if (!ctx || !ctx->planner_started)
+    return;
+
+  long trace_start = trace_begin();
+  pthread_join(ctx->planner, NULL);
+  trace_end("fft_plan_wait", trace_start);
+  ctx->planner_started = 0;
+  if (ctx->measured_plan)
+    ctx->plan = ctx->measured_plan;
+}
+
+// Write n filter outputs, starting at stage[first * decimation], into the
+// mirrored history
+static void decimate_run(fft_context_t *ctx, int first, int n) {
+  const float *in = ctx->stage + first * ctx->decimation;
+  float *out = ctx->history + ctx->history_pos;
+  dsp_decimate(in, ctx->taps, ctx->num_taps, ctx->decimation, out, n);
+  memcpy(out + ctx->fft_size, out, sizeof(float) * n);
+  ctx->history_pos = (ctx->history_pos + n) % ctx->fft_size;
+}
+
+// Low-pass and decimate newly captured samples into the history
+static void decimate_push(fft_context_t *ctx, const float *samples,
+                          int count) {
+  int capacity = ctx->num_taps + STAGE_CHUNK;
+
+  while (count > 0) {
+    int take = capacity - ctx->staged;
+    if (take > count)
+      take = count;
+    memcpy(ctx->stage + ctx->staged, samples, sizeof(float) * take);
+    ctx->staged += take;
+    samples += take;
+    count -= take;
+    if (ctx->staged < ctx->num_taps)
+      continue;
+
+    // Every output whose taps are all staged, split at the history's end
+    int n = (ctx->staged - ctx->num_taps) / ctx->decimation + 1;
+    int run = ctx->fft_size - ctx->history_pos;
+    if (run > n)
+      run = n;
+    decimate_run(ctx, 0, run);
+    if (n > run)
+      decimate_run(ctx, run, n - run);
+    ctx->decimated += n;
+
+    // Keep the samples the next outputs still need
+    int consumed = n * ctx->decimation;
+    ctx->staged -= consumed;
+    memmove(ctx->stage, ctx->stage + consumed, sizeof(float) * ctx->staged);
+  }
+}
+
+// Feed newly captured samples to engines that update per sample, and to
+// the decimation filter
+void fft_push(fft_context_t *ctx, const float *samples, int count) {
+  if (!ctx)
+    return;
+
+  long trace_start = trace_begin();
+  if (ctx->engine == ENGINE_SDFT) {
+    sdft_push(ctx->sdft, samples, count);
+    trace_end("sdft_push", trace_start);
+  } else if (ctx->decimation > 1) {
+    decimate_push(ctx, samples, count);
+    trace_end("decimate", trace_start);
+  }
+}
+
+// Decimate a whole full-rate window into the FFT input. The oldest
+// outputs lack input for their taps and are left at zero, where the Hann
+// window is close to zero anyway.
+static void decimate_window(fft_context_t *ctx, const float *audio_buffer) {
+  int n = (ctx->buffer_size - ctx->num_taps) / ctx->decimation + 1;
+  int missing = ctx->fft_size - n;
+  memset(ctx->input, 0, sizeof(float) * missing);
+  dsp_decimate(audio_buffer, ctx->taps, ctx->num_taps, ctx->decimation,
+               ctx->input + missing, n);
+}
+
+// Forget smoothing history, e.g. after an idle period
+void fft_reset(fft_context_t *ctx) {
+  if (!ctx)
+    return;
+
+  memset(ctx->prev_magnitudes, 0, sizeof(float) * 3 * ctx->num_bars);
+  ctx->last_ns = 0;
+}
+
+// Process audio buffer and generate frequency magnitudes, smoothing over
+// the time that actually passed since the previous call so the motion is
+// the same at any frame rate
 void fft_process(fft_context_t *ctx, const float *audio_buffer,
                  float *magnitudes, int bar_count) {
+  if (!ctx)
+    return;
+
+  long now = now_ns();
+  float dt = ctx->last_ns ? (now - ctx->last_ns) / 1e9f : 0.0f;
+  ctx->last_ns = now;
+  fft_process_dt(ctx, audio_buffer, magnitudes, bar_count, dt);
+}
+
+// Process audio buffer with smoothing over dt seconds (0 for the first
+// spectrum)
+void fft_process_dt(fft_context_t *ctx, const float *audio_buffer,
+                    float *magnitudes, int bar_count, float dt) {
   if (!ctx || !audio_buffer || !magnitudes)
     return;
 
-  // Apply Hann window and copy to FFT input
-  for (int i = 0; i < ctx->buffer_size; i++) {
-    float window =
-        0.5f * (1.0f - cosf(2.0f * M_PI * i / (ctx->buffer_size - 1)));
-    ctx->input[i] = audio_buffer[i] * window;
-  }
-
-  // Execute FFT
-  fftwf_execute(ctx->plan);
-
-  // Calculate frequency bin size
-  float freq_per_bin = (float)ctx->sample_rate / ctx->buffer_size;
-  int num_bins = ctx->buffer_size / 2 + 1;
-
-  // Find frequency bins for range
-  int min_bin = (int)(ctx->min_freq / freq_per_bin);
-  int max_bin = (int)(ctx->max_freq / freq_per_bin);
-  if (max_bin >= num_bins)
-    max_bin = num_bins - 1;
-
-  // Logarithmic frequency binning
-  float log_min = logf(fmaxf(1.0f, (float)ctx->min_freq));
-  float log_max = logf((float)ctx->max_freq);
-  float log_range = log_max - log_min;
-
-  for (int bar = 0; bar < bar_count; bar++) {
-    // Calculate frequency range for this bar (logarithmic)
-    float bar_log_min = log_min + (log_range * bar) / bar_count;
-    float bar_log_max = log_min + (log_range * (bar + 1)) / bar_count;
-
-    int start_bin = (int)(expf(bar_log_min) / freq_per_bin);
-    int end_bin = (int)(expf(bar_log_max) / freq_per_bin);
-
-    if (start_bin < min_bin)
-      start_bin = min_bin;
-    if (end_bin > max_bin)
-      end_bin = max_bin;
-    if (start_bin >= end_bin)
-      start_bin = end_bin - 1;
-
-    // Average magnitude in this frequency range
-    float magnitude = 0.0f;
-    int bin_count = 0;
-
-    for (int bin = start_bin; bin <= end_bin; bin++) {
-      float real = ctx->output[bin][0];
-      float imag = ctx->output[bin][1];
-      float mag = sqrtf(real * real + imag * imag);
-
-      // Apply bass boost for lower frequencies
-      if (bin < num_bins * 0.1f) {
-        mag *= ctx->bass_boost;
-      }
-
-      magnitude += mag;
-      bin_count++;
+  if (bar_count > ctx->num_bars)
+    bar_count = ctx->num_bars;
+
+  long trace_start = trace_begin();
+  if (ctx->engine == ENGINE_SDFT) {
+    // Sliding DFT bins are already up to date from fft_push()
+    sdft_read(ctx->sdft, magnitudes, bar_count);
+    trace_end("sdft_read", trace_start);
+  } else if (ctx->engine == ENGINE_FIXED) {
+    fixed_process(ctx->fixed, audio_buffer, magnitudes, bar_count);
+    trace_end("fixed_process", trace_start);
+  } else {
+    // Window straight from the caller's buffer (the capture ring), or from
+    // the decimated signal, into the FFT input
+    const float *samples = audio_buffer;
+    if (ctx->decimation > 1 && ctx->decimated >= ctx->fft_size) {
+      samples = ctx->history + ctx->history_pos;
+    } else if (ctx->decimation > 1) {
+      decimate_window(ctx, audio_buffer);
+      samples = ctx->input;
     }
-
-    if (bin_count > 0) {
-      magnitude /= bin_count;
+    dsp_window(samples, ctx->window, ctx->input, ctx->fft_size);
+
+    // Switch to the measured plan as soon as it is published
+    if (ctx->plan == ctx->estimate_plan) {
+      fftwf_plan measured =
+          __atomic_load_n(&ctx->measured_plan, __ATOMIC_ACQUIRE);
+      if (measured)
+        ctx->plan = measured;
     }
 
-    // Apply sensitivity
-    magnitude *= ctx->sensitivity;
-
-    // Normalize (scale to 0-1 range, with some headroom)
-    magnitude = sqrtf(magnitude) / 100.0f;
-    magnitude = clamp(magnitude, 0.0f, 1.0f);
-
-    // Apply temporal smoothing
-    if (ctx->prev_magnitudes) {
-      magnitude = ctx->prev_magnitudes[bar] * ctx->smoothing +
-                  magnitude * (1.0f - ctx->smoothing);
-      ctx->prev_magnitudes[bar] = magnitude;
-    }
+    // Execute FFT
+    fftwf_execute_dft_r2c(ctx->plan, ctx->input, ctx->output);
+    trace_end("fft_execute", trace_start);
 
-    magnitudes[bar] = magnitude;
+    // Bin power (with bass boost), then logarithmic bar averages
+    trace_start = trace_begin();
+    dsp_power((const float *)ctx->output, ctx->bin_gain, ctx->bin_power,
+              ctx->used_bins);
+    dsp_bin_bands(ctx->bin_power, ctx->bands, magnitudes, bar_count);
+    trace_end("bin_bands", trace_start);
   }
+
+  // Bar power to decibels, mapped from [db_floor, db_ceiling] to 0-1
+  // after the automatic gain
+  trace_start = trace_begin();
+  float offset = ctx->db_offset;
+  if (ctx->agc)
+    offset += agc_update(ctx->agc, magnitudes, bar_count, ctx->db_level, dt);
+  dsp_db_scale(magnitudes, magnitudes, bar_count, offset, ctx->db_inv_range);
+
+  // Attack/release smoothing and peak falloff
+  dsp_smooth_t smooth;
+  dsp_smooth_params(&smooth, ctx->attack_ms, ctx->release_ms, ctx->hold_ms,
+                    ctx->gravity, dt);
+  dsp_smooth(ctx->prev_magnitudes, ctx->peaks, ctx->peak_age, magnitudes,
+             &smooth, bar_count);
+  trace_end("db_smooth", trace_start);
 }
 
 // Cleanup FFT processing
@@ -168,10 +480,20 @@ void fft_cleanup(fft_context_t *ctx) {
   if (!ctx)
     return;
 
-  if (ctx->plan) {
-    fftwf_destroy_plan(ctx->plan);
+  // Planning has to finish before its buffers or plan can go away
+  if (ctx->planner_started) {
+    pthread_join(ctx->planner, NULL);
   }
 
+  pthread_mutex_lock(&planner_lock);
+  if (ctx->estimate_plan) {
+    fftwf_destroy_plan(ctx->estimate_plan);
+  }
+  if (ctx->measured_plan) {
+    fftwf_destroy_plan(ctx->measured_plan);
+  }
+  pthread_mutex_unlock(&planner_lock);
+
   if (ctx->input) {
     fftwf_free(ctx->input);
   }
@@ -184,5 +506,17 @@ void fft_cleanup(fft_context_t *ctx) {
     free(ctx->prev_magnitudes);
   }
 
+  free(ctx->window);
+  free(ctx->bin_gain);
+  free(ctx->bin_power);
+  free(ctx->bands);
+  free(ctx->taps);
+  free(ctx->stage);
+  free(ctx->history);
+  agc_cleanup(ctx->agc);
+
+  sdft_cleanup(ctx->sdft);
+  fixed_cleanup(ctx->fixed);
+
   free(ctx);
 }
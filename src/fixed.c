@@ -0,0 +1,245 @@
+#include "fixed.h"
+#include "dsp.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Number formats: samples and window are Q15, so their product is a Q30
+// FFT input with one bit of headroom; twiddles are Q31. Every butterfly
+// stage halves its outputs, which bounds the data without overflow
+// checks and leaves the spectrum scaled by 1 / buffer_size.
+#define Q15_ONE 32767
+#define Q31_ONE 2147483647.0
+
+// Magnitudes are reduced by this many bits before squaring so band sums
+// of squares fit in 64 bits
+#define MAG_SHIFT 8
+
+struct fixed_context {
+  int buffer_size; // Real FFT size N
+  int half;        // Complex FFT size N / 2
+
+  int16_t *window;   // Q15 Hann window
+  int32_t *data;     // Interleaved complex FFT data
+  int32_t *twiddle;  // W_half^k for k < half / 2 (Q31 complex)
+  int32_t *split;    // W_N^k for k < half, for the real-spectrum split
+  uint32_t *bitrev;  // Bit-reversal permutation of the complex FFT
+  uint32_t *mag;     // Approximate bin magnitudes
+
+  dsp_band_t *bands;
+  int used_bins;
+  int num_bars;
+  int boost_bins; // Bins below this get the bass boost
+  float boost;    // Bass power gain
+  float scale;    // Squared reduced magnitude to float FFT power
+};
+
+// Fixed-point multiply of a 64-bit value by a Q31 coefficient
+static inline int64_t mul_q31(int64_t x, int32_t coef) {
+  return (x * coef) >> 31;
+}
+
+// Fill a table of n Q31 complex roots e^(-2 pi i k / size)
+static void roots_table(int32_t *table, int n, int size) {
+  for (int k = 0; k < n; k++) {
+    double phase = -2.0 * M_PI * k / size;
+    table[2 * k] = (int32_t)lrint(fmin(cos(phase) * Q31_ONE, Q31_ONE));
+    table[2 * k + 1] = (int32_t)lrint(fmin(sin(phase) * Q31_ONE, Q31_ONE));
+  }
+}
+
+// Initialize the fixed-point engine
+fixed_context_t *fixed_init(int sample_rate, int buffer_size,
+                            const config_t *config) {
+  if (buffer_size < 4 || (buffer_size & (buffer_size - 1)) != 0) {
+    fprintf(stderr, "Fixed-point engine needs a power-of-two buffer size\n");
+    return NULL;
+  }
+
+  fixed_context_t *ctx = calloc(1, sizeof(fixed_context_t));
+  if (!ctx) {
+    fprintf(stderr, "Failed to allocate fixed-point context\n");
+    return NULL;
+  }
+
+  ctx->buffer_size = buffer_size;
+  ctx->half = buffer_size / 2;
+  ctx->num_bars = config->bar_count;
+  ctx->window = malloc(sizeof(int16_t) * buffer_size);
+  ctx->data = malloc(sizeof(int32_t) * buffer_size);
+  ctx->twiddle = malloc(sizeof(int32_t) * ctx->half);
+  ctx->split = malloc(sizeof(int32_t) * buffer_size);
+  ctx->bitrev = malloc(sizeof(uint32_t) * ctx->half);
+  ctx->mag = malloc(sizeof(uint32_t) * (ctx->half + 1));
+  ctx->bands = malloc(sizeof(dsp_band_t) * config->bar_count);
+  float *hann = malloc(sizeof(float) * buffer_size);
+
+  if (!ctx->window || !ctx->data || !ctx->twiddle || !ctx->split ||
+      !ctx->bitrev || !ctx->mag || !ctx->bands || !hann) {
+    fprintf(stderr, "Failed to allocate fixed-point buffers\n");
+    free(hann);
+    fixed_cleanup(ctx);
+    return NULL;
+  }
+
+  dsp_hann_table(hann, buffer_size);
+  for (int i = 0; i < buffer_size; i++)
+    ctx->window[i] = (int16_t)lrintf(hann[i] * Q15_ONE);
+  free(hann);
+
+  roots_table(ctx->twiddle, ctx->half / 2, ctx->half);
+  roots_table(ctx->split, ctx->half, buffer_size);
+
+  int bits = 0;
+  while ((1 << bits) < ctx->half)
+    bits++;
+  for (int i = 0; i < ctx->half; i++) {
+    uint32_t r = 0;
+    for (int b = 0; b < bits; b++)
+      r |= ((i >> b) & 1u) << (bits - 1 - b);
+    ctx->bitrev[i] = r;
+  }
+
+  // Same bar map and bass range as the float FFT
+  ctx->used_bins =
+      dsp_build_bands(ctx->bands, config->bar_count, sample_rate, buffer_size,
+                      config->min_freq, config->max_freq);
+  int num_bins = buffer_size / 2 + 1;
+  ctx->boost_bins = (int)ceilf(num_bins * 0.1f);
+  ctx->boost = config->bass_boost * config->bass_boost;
+
+  // |X| of the float FFT is N * 2^-30 times the fixed-point magnitude,
+  // which is 2^MAG_SHIFT times the reduced one
+  float n = (float)buffer_size;
+  ctx->scale = ldexpf(n * n, 2 * MAG_SHIFT - 60);
+  return ctx;
+}
+
+// In-place radix-2 complex FFT of ctx->half points, halving every stage
+static void fft_q31(fixed_context_t *ctx) {
+  int32_t *d = ctx->data;
+  int m = ctx->half;
+
+  for (int i = 0; i < m; i++) {
+    uint32_t j = ctx->bitrev[i];
+    if (j > (uint32_t)i) {
+      int32_t re = d[2 * i], im = d[2 * i + 1];
+      d[2 * i] = d[2 * j];
+      d[2 * i + 1] = d[2 * j + 1];
+      d[2 * j] = re;
+      d[2 * j + 1] = im;
+    }
+  }
+
+  for (int len = 2; len <= m; len *= 2) {
+    int span = len / 2;
+    int step = m / len;
+    for (int i = 0; i < m; i += len) {
+      for (int j = 0; j < span; j++) {
+        const int32_t *w = ctx->twiddle + 2 * j * step;
+        int32_t *a = d + 2 * (i + j);
+        int32_t *b = d + 2 * (i + j + span);
+        int64_t tr = ((int64_t)b[0] * w[0] - (int64_t)b[1] * w[1]) >> 31;
+        int64_t ti = ((int64_t)b[0] * w[1] + (int64_t)b[1] * w[0]) >> 31;
+        int64_t ar = a[0], ai = a[1];
+        a[0] = (int32_t)((ar + tr) >> 1);
+        a[1] = (int32_t)((ai + ti) >> 1);
+        b[0] = (int32_t)((ar - tr) >> 1);
+        b[1] = (int32_t)((ai - ti) >> 1);
+      }
+    }
+  }
+}
+
+// |re + i im| within about 3%, without a square root: the larger of
+// max and 7/8 max + 1/2 min
+static inline uint32_t magnitude(int32_t re, int32_t im) {
+  uint32_t x = re < 0 ? -(uint32_t)re : (uint32_t)re;
+  uint32_t y = im < 0 ? -(uint32_t)im : (uint32_t)im;
+  uint32_t hi = x > y ? x : y;
+  uint32_t lo = x > y ? y : x;
+  uint32_t blend = hi - (hi >> 3) + (lo >> 1);
+  return blend > hi ? blend : hi;
+}
+
+// Analyse the newest buffer_size float samples into per-bar power in the
+// same units as the float FFT path (bass boost included)
+void fixed_process(fixed_context_t *ctx, const float *samples, float *bands,
+                   int bar_count) {
+  if (!ctx || !samples || !bands)
+    return;
+
+  if (bar_count > ctx->num_bars)
+    bar_count = ctx->num_bars;
+
+  // Q15 samples (saturated) times the Q15 window, packed as complex
+  // pairs: even samples real, odd samples imaginary
+  for (int i = 0; i < ctx->buffer_size; i++) {
+    float s = samples[i] * Q15_ONE;
+    s = s > Q15_ONE ? Q15_ONE : (s < -Q15_ONE ? -Q15_ONE : s);
+    ctx->data[i] = (int32_t)lrintf(s) * ctx->window[i];
+  }
+
+  fft_q31(ctx);
+
+  // Split the half-size complex spectrum Z into the real spectrum:
+  // X[k] = (E + W^k O) / 2 with 2E = Z[k] + conj(Z[m - k]) and
+  // 2O = (Z[k] - conj(Z[m - k])) / i
+  int m = ctx->half;
+  const int32_t *z = ctx->data;
+  for (int k = 0; k < ctx->used_bins; k++) {
+    int p = k % m;
+    int q = (m - k) % m;
+    int64_t even_re = (int64_t)z[2 * p] + z[2 * q];
+    int64_t even_im = (int64_t)z[2 * p + 1] - z[2 * q + 1];
+    int64_t odd_re = (int64_t)z[2 * p + 1] + z[2 * q + 1];
+    int64_t odd_im = (int64_t)z[2 * q] - z[2 * p];
+
+    int64_t xr, xi;
+    if (k < m) {
+      const int32_t *w = ctx->split + 2 * k;
+      xr = even_re + mul_q31(odd_re, w[0]) - mul_q31(odd_im, w[1]);
+      xi = even_im + mul_q31(odd_re, w[1]) + mul_q31(odd_im, w[0]);
+    } else {
+      // Nyquist bin: W^m = -1
+      xr = even_re - odd_re;
+      xi = even_im - odd_im;
+    }
+    ctx->mag[k] = magnitude((int32_t)(xr >> 2), (int32_t)(xi >> 2));
+  }
+
+  // Integer band sums of squared magnitudes, boosted bins kept apart
+  for (int bar = 0; bar < bar_count; bar++) {
+    uint64_t plain = 0;
+    uint64_t boosted = 0;
+    int start = ctx->bands[bar].start;
+    int end = ctx->bands[bar].end;
+
+    for (int bin = start; bin <= end; bin++) {
+      uint64_t r = ctx->mag[bin] >> MAG_SHIFT;
+      if (bin < ctx->boost_bins)
+        boosted += r * r;
+      else
+        plain += r * r;
+    }
+
+    float sum = (float)plain + ctx->boost * (float)boosted;
+    bands[bar] = sum * ctx->scale / (end - start + 1);
+  }
+}
+
+// Cleanup the fixed-point engine
+void fixed_cleanup(fixed_context_t *ctx) {
+  if (!ctx)
+    return;
+
+  free(ctx->window);
+  free(ctx->data);
+  free(ctx->twiddle);
+  free(ctx->split);
+  free(ctx->bitrev);
+  free(ctx->mag);
+  free(ctx->bands);
+  free(ctx);
+}
@@ -0,0 +1,196 @@
+#include "governor.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Load is the share of wall-clock time spent analysing and drawing,
+// measured over windows of this length
+#define WINDOW_NS 250000000L
+
+// Step down after DOWN_WINDOWS windows in a row above LOAD_HIGH, and up
+// after up_windows windows in a row below LOAD_LOW. A level at most
+// doubles the cost of the one below it, so stepping up from under
+// LOAD_LOW lands under LOAD_HIGH.
+#define LOAD_HIGH 0.85f
+#define LOAD_LOW 0.35f
+#define DOWN_WINDOWS 2
+#define UP_WINDOWS 8
+#define MAX_UP_WINDOWS 128
+
+// Stepping down this soon after a step up counts as flapping and doubles
+// the windows needed for the next step up; staying up this long resets
+// them
+#define FLAP_NS 5000000000L
+
+// Minimum FFT size at QUALITY_SMALL_FFT
+#define MIN_FFT_SIZE 256
+
+struct governor {
+  int level;
+  int max_level;
+
+  // Current window
+  long window_start_ns;
+  long busy_ns;
+  int settling; // Discard the window after a change (rebuild, new plans)
+
+  // Hysteresis
+  int over;       // Windows in a row above LOAD_HIGH
+  int under;      // Windows in a row below LOAD_LOW
+  int up_windows; // Windows below LOAD_LOW needed to step up
+  long raised_ns; // Time of the last step up (0 = settled)
+
+  // Statistics for governor_report()
+  long level_ns[QUALITY_LEVELS];
+  long level_start_ns;
+  long start_ns;
+  int steps_down;
+  int lowest;
+};
+
+static const char *const level_names[QUALITY_LEVELS] = {
+    "full", "solid colors", "half rate", "half bars", "small FFT"};
+
+// Create a governor at full quality that never goes below max_level
+governor_t *governor_init(int max_level, long now_ns) {
+  governor_t *gov = calloc(1, sizeof(governor_t));
+  if (!gov) {
+    fprintf(stderr, "Failed to allocate quality governor\n");
+    return NULL;
+  }
+
+  gov->max_level = max_level < QUALITY_LEVELS ? max_level : QUALITY_LEVELS - 1;
+  gov->up_windows = UP_WINDOWS;
+  gov->window_start_ns = now_ns;
+  gov->level_start_ns = now_ns;
+  gov->start_ns = now_ns;
+  return gov;
+}
+
+// Count time spent analysing or drawing
+void governor_add(governor_t *gov, long busy_ns) {
+  if (gov)
+    gov->busy_ns += busy_ns;
+}
+
+static void set_level(governor_t *gov, int level, long now_ns) {
+  gov->level_ns[gov->level] += now_ns - gov->level_start_ns;
+  gov->level_start_ns = now_ns;
+  gov->level = level;
+  gov->over = 0;
+  gov->under = 0;
+  gov->settling = 1;
+}
+
+// Close the current window once it is long enough and move one level if
+// the load calls for it; returns 1 when the level changed
+int governor_update(governor_t *gov, long now_ns) {
+  if (!gov)
+    return 0;
+
+  long elapsed = now_ns - gov->window_start_ns;
+  if (elapsed < WINDOW_NS)
+    return 0;
+
+  float load = (float)gov->busy_ns / elapsed;
+  gov->window_start_ns = now_ns;
+  gov->busy_ns = 0;
+
+  if (gov->settling) {
+    gov->settling = 0;
+    return 0;
+  }
+
+  // A step up that held is not flapping
+  if (gov->raised_ns && now_ns - gov->raised_ns > FLAP_NS) {
+    gov->raised_ns = 0;
+    gov->up_windows = UP_WINDOWS;
+  }
+
+  gov->over = load > LOAD_HIGH ? gov->over + 1 : 0;
+  gov->under = load < LOAD_LOW ? gov->under + 1 : 0;
+
+  if (gov->over >= DOWN_WINDOWS && gov->level < gov->max_level) {
+    if (gov->raised_ns) {
+      gov->up_windows *= 2;
+      if (gov->up_windows > MAX_UP_WINDOWS)
+        gov->up_windows = MAX_UP_WINDOWS;
+      gov->raised_ns = 0;
+    }
+    set_level(gov, gov->level + 1, now_ns);
+    gov->steps_down++;
+    if (gov->level > gov->lowest)
+      gov->lowest = gov->level;
+    return 1;
+  }
+
+  if (gov->under >= gov->up_windows && gov->level > QUALITY_FULL) {
+    set_level(gov, gov->level - 1, now_ns);
+    gov->raised_ns = now_ns;
+    return 1;
+  }
+
+  return 0;
+}
+
+// Start a fresh window, e.g. after idling through silence
+void governor_reset(governor_t *gov, long now_ns) {
+  if (!gov)
+    return;
+
+  gov->window_start_ns = now_ns;
+  gov->busy_ns = 0;
+  gov->over = 0;
+  gov->under = 0;
+}
+
+// Current quality level (QUALITY_FULL without a governor)
+int governor_level(const governor_t *gov) {
+  return gov ? gov->level : QUALITY_FULL;
+}
+
+const char *governor_level_name(int level) {
+  if (level < 0 || level >= QUALITY_LEVELS)
+    return "unknown";
+  return level_names[level];
+}
+
+// Settings in force at a quality level
+void governor_apply(int level, const config_t *base, config_t *active) {
+  *active = *base;
+
+  if (level >= QUALITY_SOLID)
+    active->gradient_mode = 0;
+
+  if (level >= QUALITY_HALF_RATE) {
+    active->fps = base->fps > 1 ? base->fps / 2 : 1;
+    if (base->analysis_rate > 0)
+      active->analysis_rate =
+          base->analysis_rate > 1 ? base->analysis_rate / 2 : 1;
+  }
+
+  if (level >= QUALITY_HALF_BARS && base->bar_count > 1)
+    active->bar_count = base->bar_count / 2;
+
+  if (level >= QUALITY_SMALL_FFT && base->buffer_size >= 2 * MIN_FFT_SIZE)
+    active->buffer_size = base->buffer_size / 2;
+}
+
+// Print how long each level was in force, if the governor ever stepped in
+void governor_report(const governor_t *gov, long now_ns) {
+  if (!gov || gov->steps_down == 0)
+    return;
+
+  long total = now_ns - gov->start_ns;
+  printf("Quality governor: %d step%s down, lowest level %s\n",
+         gov->steps_down, gov->steps_down == 1 ? "" : "s",
+         level_names[gov->lowest]);
+  for (int i = 0; i <= gov->lowest; i++) {
+    long ns = gov->level_ns[i];
+    if (i == gov->level)
+      ns += now_ns - gov->level_start_ns;
+    printf("  %-12s %6.1f s (%.0f%%)\n", level_names[i], ns / 1e9,
+           total > 0 ? 100.0 * ns / total : 0.0);
+  }
+}
+
+void governor_cleanup(governor_t *gov) { free(gov); }
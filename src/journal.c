@@ -0,0 +1,336 @@
+#include "journal.h"
+#include "trace.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// File layout (host byte order):
+//   magic[8] | u32 sample rate | u32 channels | u32 sources | u32 0
+//   records: journal_record_t | frames x channels f32 samples
+// A JOURNAL_GAP record stands where buffers of its source were dropped
+// because the write-behind buffer was full; its frames field holds how
+// many.
+#define JOURNAL_MAGIC "AVJRNL1"
+
+#define JOURNAL_BLOCK 1
+#define JOURNAL_GAP 2
+
+// Write-behind buffer (power of two): about 22 seconds of stereo 48 kHz
+// float (8 MiB at 384 kB/s)
+#define BUFFER_SIZE (1 << 23)
+
+// The writer thread drains the buffer this often
+#define DRAIN_NS 20000000L
+
+typedef struct {
+  uint32_t type;
+  uint16_t source;
+  uint16_t channels;
+  uint32_t frames;
+  uint32_t chunk_size;
+  int64_t arrival_ns;
+  int64_t captured_ns;
+} journal_record_t;
+
+// Single producer (the PipeWire thread) and single consumer (the writer
+// thread) share the buffer through the head and tail counters. Drops are
+// the producer's alone: it queues their gap records ahead of the next
+// buffer that fits, so they stay in stream order.
+struct journal {
+  FILE *file;
+  const char *path;
+  long start_ns;
+  int sources;
+
+  uint8_t *buffer;
+  unsigned long head;    // Bytes produced (atomic)
+  unsigned long tail;    // Bytes consumed (atomic)
+  unsigned long dropped; // Buffers dropped in all
+  unsigned long *gaps;   // Per source: buffers dropped, not yet marked
+  int gap_sources;       // Sources with unmarked drops
+
+  pthread_t writer;
+  int writer_started;
+  int stop; // atomic
+  int failed;
+};
+
+struct journal_reader {
+  FILE *file;
+  float *samples;
+  size_t capacity; // Samples
+  int sources;
+  int *dropped; // Per source: buffers of gap records not yet reported
+};
+
+// Copy into the ring at a running byte offset, wrapping at the end
+static void ring_copy(uint8_t *ring, unsigned long offset, const void *data,
+                      size_t len) {
+  size_t pos = offset & (BUFFER_SIZE - 1);
+  size_t first = BUFFER_SIZE - pos < len ? BUFFER_SIZE - pos : len;
+  memcpy(ring + pos, data, first);
+  memcpy(ring, (const uint8_t *)data + first, len - first);
+}
+
+// Write [tail, head) to the file
+static void drain(journal_t *journal) {
+  unsigned long head = __atomic_load_n(&journal->head, __ATOMIC_ACQUIRE);
+  unsigned long tail = journal->tail;
+
+  while (tail != head) {
+    size_t pos = tail & (BUFFER_SIZE - 1);
+    size_t len = head - tail;
+    if (len > BUFFER_SIZE - pos)
+      len = BUFFER_SIZE - pos;
+    if (fwrite(journal->buffer + pos, 1, len, journal->file) != len)
+      journal->failed = 1;
+    tail += len;
+  }
+  __atomic_store_n(&journal->tail, tail, __ATOMIC_RELEASE);
+}
+
+static void *writer_main(void *data) {
+  journal_t *journal = data;
+  struct timespec interval = {.tv_sec = 0, .tv_nsec = DRAIN_NS};
+
+  trace_thread_name("journal writer");
+  while (!__atomic_load_n(&journal->stop, __ATOMIC_ACQUIRE)) {
+    nanosleep(&interval, NULL);
+    long trace_start = trace_begin();
+    drain(journal);
+    trace_end("journal_drain", trace_start);
+  }
+  drain(journal);
+  return NULL;
+}
+
+// Create the journal file and start the writer thread
+journal_t *journal_open(const char *path, int sample_rate, int channels,
+                        int sources, long start_ns) {
+  journal_t *journal = calloc(1, sizeof(journal_t));
+  if (!journal) {
+    fprintf(stderr, "Failed to allocate capture journal\n");
+    return NULL;
+  }
+
+  journal->path = path;
+  journal->start_ns = start_ns;
+  journal->sources = sources;
+  journal->buffer = malloc(BUFFER_SIZE);
+  journal->gaps = calloc(sources, sizeof(unsigned long));
+  if (!journal->buffer || !journal->gaps) {
+    fprintf(stderr, "Failed to allocate journal buffer\n");
+    journal_close(journal);
+    return NULL;
+  }
+  // Fault the buffer in now rather than from the audio thread
+  memset(journal->buffer, 0, BUFFER_SIZE);
+
+  journal->file = fopen(path, "wb");
+  if (!journal->file) {
+    fprintf(stderr, "Failed to open journal: %s\n", path);
+    journal_close(journal);
+    return NULL;
+  }
+
+  uint32_t header[4] = {sample_rate, channels, sources, 0};
+  fwrite(JOURNAL_MAGIC, 1, 8, journal->file);
+  fwrite(header, sizeof(header), 1, journal->file);
+
+  if (pthread_create(&journal->writer, NULL, writer_main, journal) != 0) {
+    fprintf(stderr, "Failed to start journal writer\n");
+    journal_close(journal);
+    return NULL;
+  }
+  journal->writer_started = 1;
+  return journal;
+}
+
+// Gap record for the buffers of a source dropped since its last one
+static void gap_record(journal_t *journal, int source,
+                       journal_record_t *record) {
+  *record = (journal_record_t){.type = JOURNAL_GAP,
+                               .source = source,
+                               .frames = journal->gaps[source]};
+  journal->gaps[source] = 0;
+}
+
+// Queue one buffer for writing. Called from the PipeWire thread: it only
+// copies into the preallocated buffer, and drops the buffer (recording a
+// gap ahead of the next one that fits) rather than wait when the writer
+// has fallen behind.
+void journal_block(journal_t *journal, const journal_block_t *block) {
+  if (!journal)
+    return;
+
+  size_t data_len = (size_t)block->frames * block->channels * sizeof(float);
+  size_t len = (journal->gap_sources + 1) * sizeof(journal_record_t) +
+               data_len;
+  unsigned long head = journal->head;
+  unsigned long tail = __atomic_load_n(&journal->tail, __ATOMIC_ACQUIRE);
+  if (BUFFER_SIZE - (head - tail) < len) {
+    if (block->source < journal->sources &&
+        journal->gaps[block->source]++ == 0)
+      journal->gap_sources++;
+    journal->dropped++;
+    return;
+  }
+
+  for (int i = 0; journal->gap_sources > 0 && i < journal->sources; i++) {
+    if (journal->gaps[i] == 0)
+      continue;
+    journal_record_t gap;
+    gap_record(journal, i, &gap);
+    ring_copy(journal->buffer, head, &gap, sizeof(gap));
+    head += sizeof(gap);
+    journal->gap_sources--;
+  }
+
+  journal_record_t record = {
+      .type = JOURNAL_BLOCK,
+      .source = block->source,
+      .channels = block->channels,
+      .frames = block->frames,
+      .chunk_size = block->chunk_size,
+      .arrival_ns = block->arrival_ns - journal->start_ns,
+      .captured_ns = block->captured_ns - journal->start_ns,
+  };
+  ring_copy(journal->buffer, head, &record, sizeof(record));
+  if (data_len > 0)
+    ring_copy(journal->buffer, head + sizeof(record), block->samples,
+              data_len);
+  __atomic_store_n(&journal->head, head + sizeof(record) + data_len,
+                   __ATOMIC_RELEASE);
+}
+
+// Stop the writer once everything queued is on disk, and close the file.
+// The producer must have stopped.
+void journal_close(journal_t *journal) {
+  if (!journal)
+    return;
+
+  if (journal->writer_started) {
+    __atomic_store_n(&journal->stop, 1, __ATOMIC_RELEASE);
+    pthread_join(journal->writer, NULL);
+
+    // Drops at the very end, with no buffer after them
+    for (int i = 0; journal->gap_sources > 0 && i < journal->sources; i++) {
+      if (journal->gaps[i] == 0)
+        continue;
+      journal_record_t gap;
+      gap_record(journal, i, &gap);
+      if (fwrite(&gap, sizeof(gap), 1, journal->file) != 1)
+        journal->failed = 1;
+      journal->gap_sources--;
+    }
+  }
+
+  if (journal->file) {
+    if (fclose(journal->file) != 0 || journal->failed)
+      fprintf(stderr, "Failed to write journal: %s\n", journal->path);
+    else if (journal->dropped > 0)
+      fprintf(stderr, "Journal %s: %lu buffers dropped (disk too slow)\n",
+              journal->path, journal->dropped);
+  }
+
+  free(journal->gaps);
+  free(journal->buffer);
+  free(journal);
+}
+
+// Open a journal for replay and read its header
+journal_reader_t *journal_reader_open(const char *path, int *sample_rate,
+                                      int *channels, int *sources) {
+  journal_reader_t *reader = calloc(1, sizeof(journal_reader_t));
+  if (!reader) {
+    fprintf(stderr, "Failed to allocate journal reader\n");
+    return NULL;
+  }
+
+  reader->file = fopen(path, "rb");
+  if (!reader->file) {
+    fprintf(stderr, "Failed to open journal: %s\n", path);
+    journal_reader_close(reader);
+    return NULL;
+  }
+
+  char magic[8];
+  uint32_t header[4];
+  if (fread(magic, 1, 8, reader->file) != 8 ||
+      memcmp(magic, JOURNAL_MAGIC, 8) != 0 ||
+      fread(header, sizeof(header), 1, reader->file) != 1 ||
+      header[0] == 0 || header[1] == 0 || header[2] == 0) {
+    fprintf(stderr, "Not a capture journal: %s\n", path);
+    journal_reader_close(reader);
+    return NULL;
+  }
+
+  reader->sources = header[2];
+  reader->dropped = calloc(reader->sources, sizeof(int));
+  if (!reader->dropped) {
+    fprintf(stderr, "Failed to allocate journal reader\n");
+    journal_reader_close(reader);
+    return NULL;
+  }
+
+  *sample_rate = header[0];
+  *channels = header[1];
+  *sources = header[2];
+  return reader;
+}
+
+// Read the next buffer, counting the buffers its source's gap markers
+// dropped since its previous one; returns 1 on success, 0 at the end of
+// the journal and -1 if it is damaged
+int journal_read(journal_reader_t *reader, journal_block_t *block) {
+  journal_record_t record;
+
+  for (;;) {
+    if (fread(&record, sizeof(record), 1, reader->file) != 1)
+      return 0;
+    if (record.source >= reader->sources)
+      return -1;
+    if (record.type == JOURNAL_BLOCK)
+      break;
+    if (record.type != JOURNAL_GAP)
+      return -1;
+    reader->dropped[record.source] += record.frames;
+  }
+
+  size_t count = (size_t)record.frames * record.channels;
+  if (count > reader->capacity) {
+    float *samples = realloc(reader->samples, count * sizeof(float));
+    if (!samples)
+      return -1;
+    reader->samples = samples;
+    reader->capacity = count;
+  }
+  if (count > 0 && fread(reader->samples, sizeof(float), count,
+                         reader->file) != count)
+    return -1;
+
+  block->source = record.source;
+  block->channels = record.channels;
+  block->frames = record.frames;
+  block->chunk_size = record.chunk_size;
+  block->arrival_ns = record.arrival_ns;
+  block->captured_ns = record.captured_ns;
+  block->dropped = reader->dropped[record.source];
+  reader->dropped[record.source] = 0;
+  block->samples = reader->samples;
+  return 1;
+}
+
+void journal_reader_close(journal_reader_t *reader) {
+  if (!reader)
+    return;
+
+  if (reader->file)
+    fclose(reader->file);
+  free(reader->dropped);
+  free(reader->samples);
+  free(reader);
+}
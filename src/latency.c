@@ -0,0 +1,131 @@
+#include "latency.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Histogram of every frame in 250 us buckets up to one second; older
+// samples land in the last bucket
+#define BUCKET_NS 250000L
+#define BUCKETS 4000
+
+// The live figure covers the frames of the last half second
+#define WINDOW_NS 500000000L
+
+struct latency {
+  unsigned long histogram[BUCKETS];
+  unsigned long count;
+  long min_ns;
+  long max_ns;
+  double sum_ns;
+
+  // Current window, and the figures of the last complete one
+  long window_start_ns;
+  long window_sum_ns;
+  long window_max_ns;
+  int window_count;
+  long live_mean_ns;
+  long live_max_ns;
+};
+
+latency_t *latency_init(long now_ns) {
+  latency_t *lat = calloc(1, sizeof(latency_t));
+  if (!lat) {
+    fprintf(stderr, "Failed to allocate latency statistics\n");
+    return NULL;
+  }
+
+  lat->window_start_ns = now_ns;
+  return lat;
+}
+
+// Count one frame; returns 1 when the live figure changed
+int latency_add(latency_t *lat, long age_ns, long now_ns) {
+  if (!lat)
+    return 0;
+  if (age_ns < 0)
+    age_ns = 0;
+
+  long bucket = age_ns / BUCKET_NS;
+  lat->histogram[bucket < BUCKETS ? bucket : BUCKETS - 1]++;
+  if (lat->count == 0 || age_ns < lat->min_ns)
+    lat->min_ns = age_ns;
+  if (age_ns > lat->max_ns)
+    lat->max_ns = age_ns;
+  lat->sum_ns += age_ns;
+  lat->count++;
+
+  lat->window_sum_ns += age_ns;
+  lat->window_count++;
+  if (age_ns > lat->window_max_ns)
+    lat->window_max_ns = age_ns;
+
+  if (now_ns - lat->window_start_ns < WINDOW_NS)
+    return 0;
+
+  lat->live_mean_ns = lat->window_sum_ns / lat->window_count;
+  lat->live_max_ns = lat->window_max_ns;
+  lat->window_start_ns = now_ns;
+  lat->window_sum_ns = 0;
+  lat->window_max_ns = 0;
+  lat->window_count = 0;
+  return 1;
+}
+
+// Live figure for the status line
+void latency_format(const latency_t *lat, char *buf, size_t size) {
+  if (!lat || lat->live_mean_ns == 0) {
+    snprintf(buf, size, "latency --");
+    return;
+  }
+  snprintf(buf, size, "latency %.1f ms, max %.1f", lat->live_mean_ns / 1e6,
+           lat->live_max_ns / 1e6);
+}
+
+// Latency below which a share of the frames fell (upper bucket edge)
+static double percentile_ms(const latency_t *lat, double share) {
+  unsigned long target = (unsigned long)(share * lat->count);
+  unsigned long seen = 0;
+  for (int i = 0; i < BUCKETS; i++) {
+    seen += lat->histogram[i];
+    if (seen > target)
+      return (i + 1) * BUCKET_NS / 1e6;
+  }
+  return BUCKETS * BUCKET_NS / 1e6;
+}
+
+// Print the distribution over the whole run
+void latency_report(const latency_t *lat) {
+  if (!lat || lat->count == 0)
+    return;
+
+  printf("Capture-to-display latency over %lu frames:\n", lat->count);
+  printf("  min %.1f ms, mean %.1f ms, max %.1f ms\n", lat->min_ns / 1e6,
+         lat->sum_ns / lat->count / 1e6, lat->max_ns / 1e6);
+  printf("  p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, p99.9 %.2f ms\n",
+         percentile_ms(lat, 0.50), percentile_ms(lat, 0.90),
+         percentile_ms(lat, 0.99), percentile_ms(lat, 0.999));
+
+  // Histogram in 5 ms bins over the occupied range
+  int bin = (int)(5000000L / BUCKET_NS);
+  int first = (int)(lat->min_ns / BUCKET_NS) / bin;
+  long last_bucket = lat->max_ns / BUCKET_NS;
+  int last = (int)(last_bucket < BUCKETS ? last_bucket : BUCKETS - 1) / bin;
+  unsigned long peak = 0;
+  for (int b = first; b <= last; b++) {
+    unsigned long n = 0;
+    for (int i = b * bin; i < (b + 1) * bin && i < BUCKETS; i++)
+      n += lat->histogram[i];
+    if (n > peak)
+      peak = n;
+  }
+
+  for (int b = first; b <= last; b++) {
+    unsigned long n = 0;
+    for (int i = b * bin; i < (b + 1) * bin && i < BUCKETS; i++)
+      n += lat->histogram[i];
+    int width = peak ? (int)(40 * n / peak) : 0;
+    printf("  %4d-%-4d ms %8lu %.*s\n", b * 5, (b + 1) * 5, n, width,
+           "########################################");
+  }
+}
+
+void latency_cleanup(latency_t *lat) { free(lat); }
@@ -0,0 +1,256 @@
+#include "layout.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#define HINT "Press 'q' to quit"
+
+// Bars per task when a frame is drawn across the canvas pool
+#define STRIP_BARS 16
+
+// Waterfall shades from silent to full scale; the top shade is bar_char
+const char *const layout_shade_chars[GLYPH_BAR] = {" ", "░", "▒", "▓"};
+
+static char hint[96] = HINT;
+
+// Show a status after the controls hint (NULL for none)
+void layout_set_status(const char *status) {
+  if (status)
+    snprintf(hint, sizeof(hint), "%s  (%s)", HINT, status);
+  else
+    snprintf(hint, sizeof(hint), "%s", HINT);
+}
+
+// Controls hint for the bottom line
+const char *layout_hint(void) { return hint; }
+
+// Map color name to its terminal color number (the ncurses COLOR_* values
+// are the ANSI color indices)
+int layout_color_code(const char *color_name) {
+  static const char *const names[] = {"black", "red",     "green", "yellow",
+                                      "blue",  "magenta", "cyan",  "white"};
+
+  for (int i = 0; i < 8; i++) {
+    if (strcasecmp(color_name, names[i]) == 0)
+      return i;
+  }
+  return 7; // White
+}
+
+// Get color pair based on height and gradient mode
+int layout_color_for_height(float height, int gradient_mode) {
+  if (gradient_mode == 0) {
+    // Solid color
+    return COLOR_PAIR_MID;
+  } else if (gradient_mode == 1) {
+    // Rainbow gradient based on height
+    if (height < 0.33f)
+      return COLOR_PAIR_LOW;
+    if (height < 0.66f)
+      return COLOR_PAIR_MID;
+    return COLOR_PAIR_HIGH;
+  } else {
+    // Custom gradient
+    if (height < 0.5f)
+      return COLOR_PAIR_LOW;
+    return COLOR_PAIR_HIGH;
+  }
+}
+
+// Number of bars that fit across width columns and their centred start
+int layout_bars(int bar_count, int width, const config_t *config,
+                int *start_x) {
+  int total_bar_width = config->bar_width + config->bar_spacing;
+  int bars_to_draw = bar_count;
+
+  // Adjust bar count if it doesn't fit
+  if (total_bar_width * bar_count > width) {
+    bars_to_draw = width / total_bar_width;
+  }
+
+  *start_x = (width - (bars_to_draw * total_bar_width)) / 2;
+  if (*start_x < 0)
+    *start_x = 0;
+
+  return bars_to_draw;
+}
+
+// Quantize a normalized magnitude to a waterfall shade level
+int layout_shade(float magnitude) {
+  float m = magnitude < 0.0f ? 0.0f : magnitude;
+  int level = (int)(m * (WATERFALL_SHADES - 1) + 0.5f);
+  return level > WATERFALL_SHADES - 1 ? WATERFALL_SHADES - 1 : level;
+}
+
+// Use the whole screen (or one tile) as the drawing area
+void layout_set_area(canvas_t *canvas, int y, int x, int height, int width) {
+  canvas->y = y;
+  canvas->x = x;
+  canvas->height = height;
+  canvas->width = width;
+}
+
+static int bar_color(float ratio, const config_t *config) {
+  if (!config->use_colors)
+    return 0;
+  return layout_color_for_height(ratio, config->gradient_mode);
+}
+
+// Draw bars [first, last) of those that fit the current area
+static void draw_bar_range(canvas_t *canvas, const float *magnitudes,
+                           int first, int last, int start_x,
+                           const config_t *config) {
+  // Calculate bar dimensions
+  int total_bar_width = config->bar_width + config->bar_spacing;
+  int area_height = canvas->height;
+  int area_width = canvas->width;
+
+  // Draw bars
+  for (int i = first; i < last; i++) {
+    float magnitude = magnitudes[i];
+
+    // Calculate bar height
+    int bar_height = (int)(magnitude * (area_height - 2));
+    if (bar_height > area_height - 1)
+      bar_height = area_height - 1;
+
+    // Calculate bar position
+    int x = start_x + (i * total_bar_width);
+
+    if (config->orientation != 1) {
+      // Vertical bars
+      int start_y = config->reverse ? 0 : (area_height - 1 - bar_height);
+      int end_y = config->reverse ? bar_height : (area_height - 1);
+
+      for (int y = start_y; y <= end_y && y < area_height; y++) {
+        float height_ratio =
+            (float)(y - start_y) / (bar_height > 0 ? bar_height : 1);
+        int color = bar_color(height_ratio, config);
+
+        // Draw bar width
+        for (int w = 0; w < config->bar_width && (x + w) < area_width; w++) {
+          canvas->put(canvas, canvas->y + y, canvas->x + x + w, GLYPH_BAR,
+                      color);
+        }
+      }
+    } else {
+      // Horizontal bars
+      int bar_y = i * 2; // Spacing for horizontal mode
+      if (bar_y >= area_height - 1)
+        break;
+
+      int start_x_bar = config->reverse ? (area_width - 1 - bar_height) : 0;
+      int end_x_bar = config->reverse ? (area_width - 1) : bar_height;
+
+      for (int x_bar = start_x_bar; x_bar <= end_x_bar && x_bar < area_width;
+           x_bar++) {
+        float width_ratio =
+            (float)(x_bar - start_x_bar) / (bar_height > 0 ? bar_height : 1);
+
+        canvas->put(canvas, canvas->y + bar_y, canvas->x + x_bar, GLYPH_BAR,
+                    bar_color(width_ratio, config));
+      }
+    }
+  }
+}
+
+// One pool task's share of layout_draw_bars()
+typedef struct {
+  canvas_t *canvas;
+  const float *magnitudes;
+  int bars;
+  int start_x;
+  const config_t *config;
+} bar_strips_t;
+
+static void draw_bar_strip(void *arg, int index) {
+  const bar_strips_t *strips = arg;
+  int first = index * STRIP_BARS;
+  int last = first + STRIP_BARS;
+  if (last > strips->bars)
+    last = strips->bars;
+
+  draw_bar_range(strips->canvas, strips->magnitudes, first, last,
+                 strips->start_x, strips->config);
+}
+
+// Draw vertical or horizontal bars into the current area. Every bar owns
+// its columns (rows when horizontal), so on a large area strips of bars
+// are drawn across the canvas pool without sharing a cell.
+void layout_draw_bars(canvas_t *canvas, const float *magnitudes,
+                      int bar_count, const config_t *config) {
+  int start_x;
+  int bars = layout_bars(bar_count, canvas->width, config, &start_x);
+
+  if (canvas->pool && bars > STRIP_BARS &&
+      canvas->height * canvas->width >= LAYOUT_PARALLEL_CELLS) {
+    bar_strips_t strips = {.canvas = canvas,
+                           .magnitudes = magnitudes,
+                           .bars = bars,
+                           .start_x = start_x,
+                           .config = config};
+    pool_run(canvas->pool, draw_bar_strip, &strips,
+             (bars + STRIP_BARS - 1) / STRIP_BARS);
+    return;
+  }
+
+  draw_bar_range(canvas, magnitudes, 0, bars, start_x, config);
+}
+
+// Paint one quantized waterfall row at screen line y, leaving silent bars
+// untouched (the line is blank after a scroll or clear)
+void layout_draw_waterfall_row(canvas_t *canvas, int y,
+                               const unsigned char *levels, int bars,
+                               int start_x, const config_t *config) {
+  int total_bar_width = config->bar_width + config->bar_spacing;
+
+  for (int i = 0; i < bars; i++) {
+    int level = levels[i];
+    if (level == 0)
+      continue;
+
+    int color = bar_color((float)level / (WATERFALL_SHADES - 1), config);
+    int x = start_x + i * total_bar_width;
+
+    for (int w = 0; w < config->bar_width && (x + w) < canvas->width; w++) {
+      canvas->put(canvas, y, x + w, level, color);
+    }
+  }
+}
+
+// Tile several sources in a near-square grid, each panel labelled on its
+// last line, with the controls hint at the bottom right. Waterfall panels
+// are drawn as bars, since scrolling applies to the whole screen.
+void layout_draw_panels(canvas_t *canvas, const float *const *magnitudes,
+                        const char *const *labels, int panels, int bar_count,
+                        int screen_height, int screen_width,
+                        const config_t *config) {
+  if (panels < 1)
+    return;
+
+  int cols = 1;
+  while (cols * cols < panels)
+    cols++;
+  int rows = (panels + cols - 1) / cols;
+  int tile_height = screen_height / rows;
+  int tile_width = screen_width / cols;
+
+  for (int p = 0; p < panels; p++) {
+    int y = (p / cols) * tile_height;
+    int x = (p % cols) * tile_width;
+
+    // One blank column between neighbouring tiles
+    int width = (p % cols) < cols - 1 ? tile_width - 1 : tile_width;
+    layout_set_area(canvas, y, x, tile_height, width);
+    if (tile_height < 2 || width < 1)
+      continue;
+
+    layout_draw_bars(canvas, magnitudes[p], bar_count, config);
+    canvas->text(canvas, y + tile_height - 1, x, labels[p], width, TEXT_BOLD);
+  }
+
+  int hint_len = (int)strlen(hint);
+  canvas->text(canvas, screen_height - 1,
+               screen_width > hint_len ? screen_width - hint_len : 0, hint, -1,
+               TEXT_DIM);
+}
@@ -1,10 +1,18 @@
 #include "audio.h"
+#include "batch.h"
 #include "config.h"
 #include "config_editor.h"
+#include "dsp.h"
 #include "fft.h"
+#include "governor.h"
+#include "latency.h"
+#include "pool.h"
+#include "record.h"
 #include "render.h"
+#include "soak.h"
+#include "trace.h"
+#include "utils.h"
 #include <errno.h>
-#include <ncurses.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -16,6 +24,9 @@
 #define CONFIG_DIR ".config/audiovis"
 #define CONFIG_FILE "config.ini"
 
+/* Analysis threads for the multi-source wall (including the main thread) */
+#define MAX_WORKERS 4
+
 static volatile int running = 1;
 
 static void signal_handler(int sig) {
@@ -86,14 +97,26 @@ static void create_default_config(const char *path) {
 
   fprintf(f, "[processing]\n");
   fprintf(f, "sensitivity = 1.50\n");
-  fprintf(f, "smoothing = 0.70\n");
+  fprintf(f, "attack_ms = 47\n");
+  fprintf(f, "release_ms = 47\n");
+  fprintf(f, "peak_hold_ms = 0\n");
+  fprintf(f, "gravity = 0.00\n");
   fprintf(f, "bass_boost = 1.20\n");
   fprintf(f, "min_freq = 20\n");
-  fprintf(f, "max_freq = 20000\n\n");
+  fprintf(f, "max_freq = 20000\n");
+  fprintf(f, "engine = 0\n");
+  fprintf(f, "db_floor = -70.0\n");
+  fprintf(f, "db_ceiling = -20.0\n");
+  fprintf(f, "agc = 0\n");
+  fprintf(f, "agc_window = 10\n\n");
 
   fprintf(f, "[performance]\n");
   fprintf(f, "fps = 60\n");
-  fprintf(f, "sleep_timer = 1000\n\n");
+  fprintf(f, "analysis_rate = 0\n");
+  fprintf(f, "sleep_timer = 1000\n");
+  fprintf(f, "backend = 0\n");
+  fprintf(f, "render_threads = 0\n");
+  fprintf(f, "governor = 1\n\n");
 
   fprintf(f, "[layout]\n");
   fprintf(f, "orientation = 0\n");
@@ -105,25 +128,305 @@ static void create_default_config(const char *path) {
   printf("Created default config: %s\n", path);
 }
 
+/* Next deadline of a periodic task; missed periods are skipped rather
+ * than run back to back */
+static long next_deadline(long deadline, long period_ns, long now) {
+  deadline += period_ns;
+  return deadline > now ? deadline : now + period_ns;
+}
+
+/* Spectra analysed per second */
+static int analysis_rate(const config_t *config) {
+  return config->analysis_rate > 0 ? config->analysis_rate : config->fps;
+}
+
+/* Display spectrum t of the way from the previous analysis to the newest
+ * (t clamped to [0, 1]) */
+static void interpolate_spectra(const float *previous, const float *newest,
+                                float t, float *out, int n) {
+  t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+  for (int i = 0; i < n; i++)
+    out[i] = previous[i] + (newest[i] - previous[i]) * t;
+}
+
+/* Map a --backend name to its config value (-1 if unknown) */
+static int parse_backend(const char *name) {
+  if (strcmp(name, "ncurses") == 0)
+    return BACKEND_NCURSES;
+  if (strcmp(name, "ansi") == 0)
+    return BACKEND_ANSI;
+  if (strcmp(name, "headless") == 0)
+    return BACKEND_HEADLESS;
+  return -1;
+}
+
+/* Feed render_frame() from a recording, paced or as fast as possible */
+static int run_replay(const char *path, int max_speed, int backend,
+                      const char *dump_path) {
+  config_t config;
+  replayer_t *rp = replay_open(path, &config);
+  if (!rp)
+    return 1;
+  if (backend >= 0)
+    config.backend = backend;
+
+  float *magnitudes = calloc(config.bar_count, sizeof(float));
+  if (!magnitudes || !render_init(&config)) {
+    fprintf(stderr, "Failed to initialize renderer\n");
+    free(magnitudes);
+    replay_close(rp);
+    return 1;
+  }
+
+  signal(SIGINT, signal_handler);
+  signal(SIGTERM, signal_handler);
+
+  long frames = 0;
+  long render_ns = 0;
+  long timestamp_ns;
+  long start_ns = now_ns();
+
+  while (running && replay_frame(rp, magnitudes, config.bar_count,
+                                 &timestamp_ns)) {
+    int ch = render_getch();
+    if (ch == 'q' || ch == 'Q' || ch == 27)
+      break;
+
+    if (!max_speed) {
+      long sleep_ns = start_ns + timestamp_ns - now_ns();
+      if (sleep_ns > 0) {
+        struct timespec sleep_time = {.tv_sec = sleep_ns / 1000000000L,
+                                      .tv_nsec = sleep_ns % 1000000000L};
+        nanosleep(&sleep_time, NULL);
+      }
+    }
+
+    long render_start_ns = now_ns();
+    render_frame(magnitudes, config.bar_count, &config);
+    render_ns += now_ns() - render_start_ns;
+    frames++;
+  }
+
+  long elapsed_ns = now_ns() - start_ns;
+  int dump_failed = dump_path && render_dump(dump_path, &config) != 0;
+  render_cleanup();
+  free(magnitudes);
+  replay_close(rp);
+
+  printf("Replayed %ld frames in %.3f s\n", frames, elapsed_ns / 1e9);
+  if (frames > 0)
+    printf("render_frame: %.1f us/frame average\n",
+           render_ns / 1e3 / frames);
+  return dump_failed ? 1 : 0;
+}
+
+/* Per-source analysis state shared with the worker pool */
+typedef struct {
+  audio_context_t *audio;
+  fft_context_t **fft;
+  float *magnitudes; /* sources x bar_count */
+  int buffer_size;
+  int bar_count;
+  long captured_ns[AUDIO_MAX_SOURCES]; /* Newest sample analysed */
+} analysis_t;
+
+/* Worker task: analyse the newest window of one source in place; every
+ * sample that arrived since the last analysis, even more than a window,
+ * goes to the per-sample engines and the decimation filter */
+static void analyse_source(void *arg, int source) {
+  analysis_t *a = arg;
+  const float *fresh_samples;
+  int fresh;
+  const float *window = audio_get_window(a->audio, source, a->buffer_size,
+                                         &fresh_samples, &fresh);
+  float *magnitudes = a->magnitudes + source * a->bar_count;
+  long trace_start = trace_begin();
+  a->captured_ns[source] = audio_window_time(a->audio, source);
+
+  fft_push(a->fft[source], fresh_samples, fresh);
+  fft_process(a->fft[source], window, magnitudes, a->bar_count);
+  trace_end("analyse_source", trace_start);
+}
+
+static void cleanup_ffts(fft_context_t **fft, int count) {
+  if (!fft)
+    return;
+  for (int i = 0; i < count; i++)
+    fft_cleanup(fft[i]);
+  free(fft);
+}
+
+/* Switch to the settings of a quality level. The analysis is rebuilt when
+ * its bar count or FFT size changes, keeping the current one if that
+ * fails; the spectrum buffers restart from silence. */
+static void set_quality(int level, const config_t *config, config_t *active,
+                        analysis_t *analysis, int sources,
+                        const float **panel_magnitudes, const float *shown) {
+  config_t next;
+  governor_apply(level, config, &next);
+
+  if (next.bar_count != active->bar_count ||
+      next.buffer_size != active->buffer_size) {
+    fft_context_t **fft = calloc(sources, sizeof(fft_context_t *));
+    for (int i = 0; fft && i < sources; i++) {
+      fft[i] = fft_init(next.sample_rate, next.buffer_size, &next);
+      if (!fft[i]) {
+        cleanup_ffts(fft, i);
+        fft = NULL;
+      }
+    }
+
+    if (fft) {
+      for (int i = 0; i < sources; i++) {
+        fft_cleanup(analysis->fft[i]);
+        analysis->fft[i] = fft[i];
+      }
+      free(fft);
+      memset(analysis->magnitudes, 0,
+             3 * sources * config->bar_count * sizeof(float));
+    } else {
+      next.bar_count = active->bar_count;
+      next.buffer_size = active->buffer_size;
+    }
+  }
+
+  analysis->bar_count = next.bar_count;
+  analysis->buffer_size = next.buffer_size;
+  for (int i = 0; i < sources; i++)
+    panel_magnitudes[i] = shown + i * next.bar_count;
+  *active = next;
+}
+
+/* Status after the controls hint: reduced quality and live latency */
+static void show_status(const governor_t *governor, const latency_t *latency) {
+  char status[96];
+  int len = 0;
+  int level = governor_level(governor);
+
+  if (level > QUALITY_FULL)
+    len = snprintf(status, sizeof(status), "quality: %s",
+                   governor_level_name(level));
+  if (latency) {
+    if (len > 0)
+      len += snprintf(status + len, sizeof(status) - len, ", ");
+    latency_format(latency, status + len, sizeof(status) - len);
+    len = strlen(status);
+  }
+  render_status(len > 0 ? status : NULL);
+}
+
 int main(int argc, char **argv) {
   int editor_mode = 0;
+  const char *record_path = NULL;
+  const char *replay_path = NULL;
+  int max_speed = 0;
+  const char *isa = NULL;
+  const char *batch_input = NULL;
+  const char *batch_output = NULL;
+  int batch_hop = 0;
+  int batch_threads = 0;
+  int backend = -1;
+  const char *trace_path = NULL;
+  const char *dump_path = NULL;
+  int latency_mode = 0;
+  const char *journal_path = NULL;
+  const char *journal_replay_path = NULL;
+  int soak_seconds = 0;
 
   /* Parse command line arguments */
   for (int i = 1; i < argc; i++) {
     if (strcmp(argv[i], "--config") == 0 || strcmp(argv[i], "-c") == 0) {
       editor_mode = 1;
+    } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      record_path = argv[++i];
+    } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      replay_path = argv[++i];
+    } else if (strcmp(argv[i], "--max-speed") == 0) {
+      max_speed = 1;
+    } else if (strcmp(argv[i], "--isa") == 0 && i + 1 < argc) {
+      isa = argv[++i];
+    } else if (strcmp(argv[i], "--batch") == 0 && i + 2 < argc) {
+      batch_input = argv[++i];
+      batch_output = argv[++i];
+    } else if (strcmp(argv[i], "--hop") == 0 && i + 1 < argc) {
+      batch_hop = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      batch_threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+      trace_path = argv[++i];
+    } else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+      journal_path = argv[++i];
+    } else if (strcmp(argv[i], "--journal-replay") == 0 && i + 1 < argc) {
+      journal_replay_path = argv[++i];
+    } else if (strcmp(argv[i], "--soak") == 0 && i + 1 < argc) {
+      soak_seconds = atoi(argv[++i]);
+      if (soak_seconds < 1) {
+        fprintf(stderr, "Soak duration must be at least a second\n");
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--latency") == 0) {
+      latency_mode = 1;
+    } else if (strcmp(argv[i], "--backend") == 0 && i + 1 < argc) {
+      backend = parse_backend(argv[++i]);
+      if (backend < 0) {
+        fprintf(stderr, "Unknown backend: %s (ncurses, ansi or headless)\n",
+                argv[i]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+      dump_path = argv[++i];
     } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
       printf("audiovis - Terminal audio visualizer\n\n");
       printf("Usage: audiovis [OPTIONS]\n\n");
       printf("Options:\n");
-      printf("  -c, --config    Open configuration editor\n");
-      printf("  -h, --help      Show this help message\n\n");
+      printf("  -c, --config        Open configuration editor\n");
+      printf("  --record FILE       Record the spectrum stream to FILE\n");
+      printf("  --replay FILE       Render a recorded spectrum stream\n");
+      printf("  --max-speed         Replay without pacing (benchmark)\n");
+      printf("  --isa NAME          Force DSP kernels (scalar, sse2, avx2,\n");
+      printf("                      avx512, neon)\n");
+      printf("  --batch IN OUT      Analyse WAV file IN into a spectrogram\n");
+      printf("                      (OUT.csv, or a --replay recording)\n");
+      printf("  --hop N             Batch frame step in samples\n");
+      printf("                      (default: buffer_size / 2)\n");
+      printf("  --threads N         Batch threads (default: all cores)\n");
+      printf("  --backend NAME      Renderer: ncurses, ansi (direct output,\n");
+      printf("                      synchronized when supported) or\n");
+      printf("                      headless (in-memory $COLUMNS x $LINES)\n");
+      printf("  --dump FILE         Write the last headless frame to FILE\n");
+      printf("  --trace FILE        Write per-frame spans to FILE as\n");
+      printf("                      Chrome trace-event JSON at exit\n");
+      printf("  --journal FILE      Journal every captured buffer to FILE\n");
+      printf("  --journal-replay FILE\n");
+      printf("                      Capture from a journal instead, with\n");
+      printf("                      its original buffer sizes and timing\n");
+      printf("  --latency           Show capture-to-display latency live\n");
+      printf("                      and its distribution at exit\n");
+      printf("  --soak SECONDS      Run at full speed for SECONDS on a\n");
+      printf("                      synthetic signal (or a looped\n");
+      printf("                      --journal-replay FILE) and fail if\n");
+      printf("                      resources or frame time drift\n");
+      printf("  -h, --help          Show this help message\n\n");
       printf("Config file: ~/.config/audiovis/config.ini\n");
       printf("Controls: q/ESC to quit\n");
       return 0;
     }
   }
 
+  /* Spans are collected from here on and written out at exit */
+  if (trace_path) {
+    if (trace_open(trace_path) != 0)
+      return 1;
+    atexit(trace_close);
+  }
+
+  /* Pick DSP kernels for this CPU once, before anything runs them */
+  if (dsp_init(isa) != 0)
+    return 1;
+
+  if (replay_path)
+    return run_replay(replay_path, max_speed, backend, dump_path);
+
   /* Setup config path */
   char config_path[512];
   if (get_config_path(config_path, sizeof(config_path)) != 0)
@@ -136,78 +439,309 @@ int main(int argc, char **argv) {
   /* Load configuration */
   config_t config;
   config_load(config_path, &config);
+  if (backend >= 0)
+    config.backend = backend;
+
+  /* Offline analysis uses the configured analysis settings */
+  if (batch_input)
+    return batch_run(batch_input, batch_output, &config, batch_hop,
+                     batch_threads)
+               ? 1
+               : 0;
 
   /* Launch config editor if requested */
   if (editor_mode) {
     return config_editor_run(&config, config_path);
   }
 
-  /* Initialize subsystems */
-  audio_context_t *audio = audio_init(&config);
+  /* The soak test runs this same loop on a fed source, headless unless a
+   * backend was asked for */
+  soak_t *soak = NULL;
+  if (soak_seconds > 0) {
+    if (backend < 0)
+      config.backend = BACKEND_HEADLESS;
+    soak = soak_init(&config, journal_replay_path, soak_seconds);
+    if (!soak)
+      return 1;
+  }
+
+  /* Initialize subsystems. A replayed journal brings its own sample
+   * rate, so it is set up before anything sized from config */
+  audio_context_t *audio;
+  if (soak)
+    audio = soak_audio(soak, &config);
+  else if (journal_replay_path)
+    audio = audio_init_replay(journal_replay_path, &config);
+  else
+    audio = audio_init(&config, journal_path);
   if (!audio) {
     fprintf(stderr, "Failed to initialize audio capture\n");
+    soak_cleanup(soak);
     return 1;
   }
 
-  fft_context_t *fft =
-      fft_init(config.sample_rate, config.buffer_size, &config);
-  if (!fft) {
-    fprintf(stderr, "Failed to initialize FFT\n");
+  /* One analysis per captured source; FFTW reuses the plan wisdom from
+   * the first, so extra sources only cost their own FFT per frame. Plans
+   * start as estimates and are measured in the background, overlapping
+   * the PipeWire connection (already running on its thread) and
+   * render_init() */
+  int sources = audio_source_count(audio);
+  fft_context_t **fft = calloc(sources, sizeof(fft_context_t *));
+  for (int i = 0; fft && i < sources; i++) {
+    fft[i] = fft_init(config.sample_rate, config.buffer_size, &config);
+    if (!fft[i]) {
+      fprintf(stderr, "Failed to initialize FFT\n");
+      cleanup_ffts(fft, i);
+      audio_cleanup(audio);
+      soak_cleanup(soak);
+      return 1;
+    }
+  }
+
+  /* Newest analysis, the one before it and the interpolated display
+   * spectrum, sources x bar_count each, in one block */
+  int spectrum_size = sources * config.bar_count;
+  float *magnitudes = calloc(3 * spectrum_size, sizeof(float));
+  float *previous = magnitudes + spectrum_size;
+  float *display = previous + spectrum_size;
+  const float **panel_magnitudes = malloc(sources * sizeof(float *));
+  const char **panel_labels = malloc(sources * sizeof(char *));
+
+  if (!fft || !magnitudes || !panel_magnitudes || !panel_labels) {
+    fprintf(stderr, "Failed to allocate buffers\n");
+    free(panel_labels);
+    free(panel_magnitudes);
+    free(magnitudes);
+    cleanup_ffts(fft, sources);
     audio_cleanup(audio);
+    soak_cleanup(soak);
     return 1;
   }
 
+  /* Analysis and display run on their own deadlines. When analysis is
+   * slower than the display, the frames in between interpolate from the
+   * previous spectrum to the newest over one analysis interval (one
+   * interval of latency for motion at the full display rate); otherwise
+   * each frame shows the newest spectrum */
+  int interpolate = analysis_rate(&config) < config.fps;
+  const float *shown = interpolate ? display : magnitudes;
+
+  for (int i = 0; i < sources; i++) {
+    panel_magnitudes[i] = shown + i * config.bar_count;
+    panel_labels[i] = audio_source_name(audio, i);
+  }
+
+  /* A small pool analyses the sources of a wall in parallel */
+  worker_pool_t *pool = NULL;
+  if (sources > 1) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = sources < MAX_WORKERS ? sources : MAX_WORKERS;
+    if (cpus > 0 && threads > cpus)
+      threads = (int)cpus;
+    pool = pool_init(threads);
+  }
+
+  analysis_t analysis = {
+      .audio = audio,
+      .fft = fft,
+      .magnitudes = magnitudes,
+      .buffer_size = config.buffer_size,
+      .bar_count = config.bar_count,
+  };
+
   if (!render_init(&config)) {
     fprintf(stderr, "Failed to initialize renderer\n");
-    fft_cleanup(fft);
+    pool_cleanup(pool);
+    free(panel_labels);
+    free(panel_magnitudes);
+    free(magnitudes);
+    cleanup_ffts(fft, sources);
     audio_cleanup(audio);
+    soak_cleanup(soak);
     return 1;
   }
 
   signal(SIGINT, signal_handler);
   signal(SIGTERM, signal_handler);
 
-  float *audio_buffer = malloc(config.buffer_size * sizeof(float));
-  float *magnitudes = malloc(config.bar_count * sizeof(float));
+  /* Recordings hold the first source */
+  recorder_t *recorder = NULL;
+  if (record_path) {
+    recorder = record_open(record_path, &config);
+    if (!recorder) {
+      render_cleanup();
+      pool_cleanup(pool);
+      free(panel_labels);
+      free(panel_magnitudes);
+      free(magnitudes);
+      cleanup_ffts(fft, sources);
+      audio_cleanup(audio);
+      soak_cleanup(soak);
+      return 1;
+    }
+  }
 
-  if (!audio_buffer || !magnitudes) {
-    fprintf(stderr, "Failed to allocate buffers\n");
-    render_cleanup();
-    fft_cleanup(fft);
-    audio_cleanup(audio);
-    return 1;
+  /* Under load the governor trades quality for time; recordings keep
+   * their bar count, so they only go as far as half rate. active holds
+   * the settings of the current level. */
+  config_t active = config;
+  governor_t *governor = NULL;
+  if (config.governor)
+    governor = governor_init(recorder ? QUALITY_HALF_RATE : QUALITY_LEVELS - 1,
+                             now_ns());
+
+  /* With --latency, every frame is timed from the capture of the newest
+   * sample it shows to the moment it was flushed to the terminal */
+  latency_t *latency = NULL;
+  if (latency_mode) {
+    latency = latency_init(now_ns());
+    show_status(governor, latency);
   }
 
-  struct timespec frame_time;
-  long frame_delay_ns = 1000000000L / config.fps;
+  long frame_delay_ns = 1000000000L / active.fps;
+  long analysis_delay_ns = 1000000000L / analysis_rate(&active);
+  long record_start_ns = now_ns();
+  long next_frame_ns = record_start_ns;
+  long next_analysis_ns = record_start_ns;
+  long analysed_ns = record_start_ns; /* Time of the newest analysis */
 
   while (running) {
-    clock_gettime(CLOCK_MONOTONIC, &frame_time);
-    long frame_start_ns = frame_time.tv_sec * 1000000000L + frame_time.tv_nsec;
-
-    int ch = getch();
+    int ch = render_getch();
     if (ch == 'q' || ch == 'Q' || ch == 27)
       break;
 
-    audio_get_buffer(audio, audio_buffer, config.buffer_size);
-    fft_process(fft, audio_buffer, magnitudes, config.bar_count);
-    render_frame(magnitudes, config.bar_count, &config);
+    /* After sleep_timer ms of silence on every source clear the spectra,
+     * draw one empty frame and block until sound resumes (or a key is
+     * pressed) instead of polling */
+    if (config.sleep_timer > 0 &&
+        audio_silence_ms(audio) >= config.sleep_timer) {
+      memset(magnitudes, 0, 3 * spectrum_size * sizeof(float));
+      if (sources > 1)
+        render_panels(panel_magnitudes, panel_labels, sources,
+                      active.bar_count, &active);
+      else
+        render_frame(shown, active.bar_count, &active);
+      for (int i = 0; i < sources; i++)
+        fft_reset(fft[i]);
+
+      long trace_start = trace_begin();
+      audio_wait_for_sound(audio, render_input_fd());
+      trace_end("idle", trace_start);
+
+      next_frame_ns = next_analysis_ns = now_ns();
+      governor_reset(governor, next_frame_ns);
+      continue;
+    }
+
+    long now = now_ns();
+    int active_size = sources * active.bar_count;
+    int worked = 0;
+
+    if (now >= next_analysis_ns) {
+      long trace_start = trace_begin();
+      if (interpolate)
+        memcpy(previous, magnitudes, active_size * sizeof(float));
+      pool_run(pool, analyse_source, &analysis, sources);
+      analysed_ns = now;
+
+      if (recorder)
+        record_frame(recorder, magnitudes, config.bar_count,
+                     now - record_start_ns);
+      next_analysis_ns = next_deadline(next_analysis_ns, analysis_delay_ns,
+                                       now);
+      trace_end("analysis", trace_start);
+      worked = 1;
+    }
+
+    if (now >= next_frame_ns) {
+      long trace_start = trace_begin();
+      if (interpolate)
+        interpolate_spectra(previous, magnitudes,
+                            (float)(now - analysed_ns) / analysis_delay_ns,
+                            display, active_size);
+      if (sources > 1)
+        render_panels(panel_magnitudes, panel_labels, sources,
+                      active.bar_count, &active);
+      else
+        render_frame(shown, active.bar_count, &active);
+      next_frame_ns = next_deadline(next_frame_ns, frame_delay_ns, now);
+      trace_end("frame", trace_start);
+      worked = 1;
+
+      long newest_ns = 0;
+      for (int i = 0; latency && i < sources; i++)
+        if (analysis.captured_ns[i] > newest_ns)
+          newest_ns = analysis.captured_ns[i];
+      if (newest_ns > 0) {
+        long flushed_ns = now_ns();
+        if (latency_add(latency, flushed_ns - newest_ns, flushed_ns))
+          show_status(governor, latency);
+      }
+    }
 
-    clock_gettime(CLOCK_MONOTONIC, &frame_time);
-    long frame_end_ns = frame_time.tv_sec * 1000000000L + frame_time.tv_nsec;
-    long sleep_ns = frame_delay_ns - (frame_end_ns - frame_start_ns);
+    if (worked && (governor || soak)) {
+      long done = now_ns();
+      if (governor) {
+        governor_add(governor, done - now);
+        if (governor_update(governor, done)) {
+          set_quality(governor_level(governor), &config, &active, &analysis,
+                      sources, panel_magnitudes, shown);
+          frame_delay_ns = 1000000000L / active.fps;
+          analysis_delay_ns = 1000000000L / analysis_rate(&active);
+          show_status(governor, latency);
+        }
+      }
+      if (soak) {
+        /* Each governor step measures new FFT plans on a thread of its
+         * own; let them finish so a sample counts the lasting threads */
+        if (soak_sample_due(soak, done))
+          for (int i = 0; i < sources; i++)
+            fft_wait_plan(fft[i]);
+        if (soak_frame(soak, done - now, done))
+          break;
+      }
+    }
 
-    if (sleep_ns > 0) {
-      struct timespec sleep_time = {.tv_sec = 0, .tv_nsec = sleep_ns};
-      nanosleep(&sleep_time, NULL);
+    /* Sleep until whichever is due first. A soak test runs at full
+     * speed instead: the schedule moves back by the time it would have
+     * slept, keeping analysis, frames and interpolation in step */
+    long wake_ns =
+        next_frame_ns < next_analysis_ns ? next_frame_ns : next_analysis_ns;
+    if (soak) {
+      long skip_ns = wake_ns - now_ns();
+      if (skip_ns > 0) {
+        next_frame_ns -= skip_ns;
+        next_analysis_ns -= skip_ns;
+        analysed_ns -= skip_ns;
+      }
+    } else {
+      struct timespec wake = {.tv_sec = wake_ns / 1000000000L,
+                              .tv_nsec = wake_ns % 1000000000L};
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL);
     }
   }
 
-  free(magnitudes);
-  free(audio_buffer);
+  if (soak) {
+    for (int i = 0; i < sources; i++)
+      fft_wait_plan(fft[i]);
+    soak_stop(soak, now_ns());
+  }
+  record_close(recorder);
+  if (dump_path)
+    render_dump(dump_path, &active);
   render_cleanup();
-  fft_cleanup(fft);
+  governor_report(governor, now_ns());
+  governor_cleanup(governor);
+  latency_report(latency);
+  latency_cleanup(latency);
+  pool_cleanup(pool);
+  free(panel_labels);
+  free(panel_magnitudes);
+  free(magnitudes);
+  cleanup_ffts(fft, sources);
   audio_cleanup(audio);
 
-  return 0;
+  int status = soak ? soak_report(soak) : 0;
+  soak_cleanup(soak);
+  return status;
 }
@@ -0,0 +1,141 @@
+#include "pool.h"
+#include "trace.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Worker pool structure
+struct worker_pool {
+  pthread_t *threads;
+  int num_threads; // Workers besides the calling thread
+
+  pthread_mutex_t mutex;
+  pthread_cond_t start; // A new batch was posted (or stop was set)
+  pthread_cond_t done;  // The last busy worker finished its batch
+
+  // Current batch (protected by mutex)
+  pool_task_fn fn;
+  void *arg;
+  int count;
+  int next;       // Next task index to hand out
+  int busy;       // Workers still inside the batch
+  unsigned batch; // Incremented for every pool_run()
+  int stop;
+};
+
+// Take task indices until the batch is exhausted
+static void run_tasks(worker_pool_t *pool) {
+  for (;;) {
+    pthread_mutex_lock(&pool->mutex);
+    int index = pool->next < pool->count ? pool->next++ : -1;
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (index < 0)
+      return;
+    pool->fn(pool->arg, index);
+  }
+}
+
+static void *worker_main(void *data) {
+  worker_pool_t *pool = data;
+  unsigned seen = 0;
+
+  trace_thread_name("pool worker");
+
+  pthread_mutex_lock(&pool->mutex);
+  for (;;) {
+    while (pool->batch == seen && !pool->stop)
+      pthread_cond_wait(&pool->start, &pool->mutex);
+    if (pool->stop)
+      break;
+    seen = pool->batch;
+    pthread_mutex_unlock(&pool->mutex);
+
+    run_tasks(pool);
+
+    pthread_mutex_lock(&pool->mutex);
+    if (--pool->busy == 0)
+      pthread_cond_signal(&pool->done);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+
+  return NULL;
+}
+
+// Start threads - 1 workers; the caller of pool_run() is the last one
+worker_pool_t *pool_init(int threads) {
+  worker_pool_t *pool = calloc(1, sizeof(worker_pool_t));
+  if (!pool) {
+    fprintf(stderr, "Failed to allocate worker pool\n");
+    return NULL;
+  }
+
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->start, NULL);
+  pthread_cond_init(&pool->done, NULL);
+
+  int workers = threads > 1 ? threads - 1 : 0;
+  pool->threads = calloc(workers > 0 ? workers : 1, sizeof(pthread_t));
+  if (!pool->threads) {
+    fprintf(stderr, "Failed to allocate worker threads\n");
+    pool_cleanup(pool);
+    return NULL;
+  }
+
+  for (int i = 0; i < workers; i++) {
+    if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0) {
+      fprintf(stderr, "Failed to start worker thread\n");
+      pool_cleanup(pool);
+      return NULL;
+    }
+    pool->num_threads++;
+  }
+
+  return pool;
+}
+
+// Run fn(arg, i) for i in [0, count) and wait for all of them
+void pool_run(worker_pool_t *pool, pool_task_fn fn, void *arg, int count) {
+  if (!pool || pool->num_threads == 0 || count < 2) {
+    for (int i = 0; i < count; i++)
+      fn(arg, i);
+    return;
+  }
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->fn = fn;
+  pool->arg = arg;
+  pool->count = count;
+  pool->next = 0;
+  pool->busy = pool->num_threads;
+  pool->batch++;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->mutex);
+
+  run_tasks(pool);
+
+  pthread_mutex_lock(&pool->mutex);
+  while (pool->busy > 0)
+    pthread_cond_wait(&pool->done, &pool->mutex);
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+// Stop and join the workers
+void pool_cleanup(worker_pool_t *pool) {
+  if (!pool)
+    return;
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->stop = 1;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->mutex);
+
+  for (int i = 0; i < pool->num_threads; i++)
+    pthread_join(pool->threads[i], NULL);
+
+  pthread_cond_destroy(&pool->done);
+  pthread_cond_destroy(&pool->start);
+  pthread_mutex_destroy(&pool->mutex);
+  free(pool->threads);
+  free(pool);
+}
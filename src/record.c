@@ -0,0 +1,275 @@
+#include "record.h"
+#include "utils.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// File layout (integers little-endian):
+//   magic[8] | u32 version
+//   u32 bar_count, fps, use_colors, gradient_mode, orientation, reverse,
+//       bar_width, bar_spacing
+//   strings bar_char, color_low, color_mid, color_high (u8 length, bytes)
+//   frames:  varint dt_us | bar_count x zigzag varint delta
+// Only the settings the renderer uses are stored, each on its own, so
+// adding config fields does not break older recordings. Bars are
+// quantized to QUANT_LEVELS steps and stored as the difference from the
+// same bar in the previous frame, so steady bars cost one byte.
+#define RECORD_MAGIC "AVSPEC"
+#define RECORD_VERSION 2
+#define QUANT_LEVELS 4095
+
+// Limits on header values read back from a file
+#define MAX_BARS 4096
+#define MAX_FPS 1000
+#define MAX_BAR_WIDTH 100
+
+struct recorder {
+  FILE *file;
+  int bar_count;
+  int *prev; // Previous quantized value per bar
+  long last_ns;
+};
+
+struct replayer {
+  FILE *file;
+  int bar_count;
+  int *prev;
+  long time_ns;
+};
+
+static void write_varint(FILE *f, uint32_t v) {
+  while (v >= 0x80) {
+    fputc((v & 0x7f) | 0x80, f);
+    v >>= 7;
+  }
+  fputc(v, f);
+}
+
+static int read_varint(FILE *f, uint32_t *v) {
+  uint32_t result = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    int c = fgetc(f);
+    if (c == EOF)
+      return 0;
+    result |= (uint32_t)(c & 0x7f) << shift;
+    if (!(c & 0x80)) {
+      *v = result;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void write_u32(FILE *f, uint32_t v) {
+  for (int i = 0; i < 4; i++)
+    fputc((v >> (8 * i)) & 0xff, f);
+}
+
+static int read_u32(FILE *f, uint32_t *v) {
+  uint8_t b[4];
+  if (fread(b, 1, 4, f) != 4)
+    return 0;
+  *v = b[0] | b[1] << 8 | b[2] << 16 | (uint32_t)b[3] << 24;
+  return 1;
+}
+
+static void write_string(FILE *f, const char *s, size_t size) {
+  size_t len = strnlen(s, size - 1);
+  fputc((int)len, f);
+  fwrite(s, 1, len, f);
+}
+
+// Read a string into a buffer of size bytes, NUL-terminated; it must be
+// non-empty and fit
+static int read_string(FILE *f, char *s, size_t size) {
+  int len = fgetc(f);
+  if (len <= 0 || (size_t)len >= size || fread(s, 1, len, f) != (size_t)len)
+    return 0;
+  s[len] = '\0';
+  return strlen(s) > 0;
+}
+
+// Read a u32 into *value if it lies in [min, max]
+static int read_int(FILE *f, int *value, int min, int max) {
+  uint32_t v;
+  if (!read_u32(f, &v) || v < (uint32_t)min || v > (uint32_t)max)
+    return 0;
+  *value = (int)v;
+  return 1;
+}
+
+static uint32_t zigzag(int v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+
+static int unzigzag(uint32_t v) { return (int)(v >> 1) ^ -(int)(v & 1); }
+
+// Open a recording and write the header
+recorder_t *record_open(const char *filename, const config_t *config) {
+  recorder_t *rec = calloc(1, sizeof(recorder_t));
+  if (!rec) {
+    fprintf(stderr, "Failed to allocate recorder\n");
+    return NULL;
+  }
+
+  rec->bar_count = config->bar_count;
+  rec->prev = calloc(rec->bar_count, sizeof(int));
+  rec->file = fopen(filename, "wb");
+  if (!rec->prev || !rec->file) {
+    fprintf(stderr, "Failed to open recording: %s\n", filename);
+    record_close(rec);
+    return NULL;
+  }
+
+  char magic[8] = RECORD_MAGIC;
+  fwrite(magic, 1, 8, rec->file);
+  write_u32(rec->file, RECORD_VERSION);
+  write_u32(rec->file, rec->bar_count);
+  write_u32(rec->file, config->fps);
+  write_u32(rec->file, config->use_colors);
+  write_u32(rec->file, config->gradient_mode);
+  write_u32(rec->file, config->orientation);
+  write_u32(rec->file, config->reverse);
+  write_u32(rec->file, config->bar_width);
+  write_u32(rec->file, config->bar_spacing);
+  write_string(rec->file, config->bar_char, sizeof(config->bar_char));
+  write_string(rec->file, config->color_low, sizeof(config->color_low));
+  write_string(rec->file, config->color_mid, sizeof(config->color_mid));
+  write_string(rec->file, config->color_high, sizeof(config->color_high));
+
+  return rec;
+}
+
+// Append one frame of magnitudes
+int record_frame(recorder_t *rec, const float *magnitudes, int bar_count,
+                 long timestamp_ns) {
+  if (!rec || !magnitudes)
+    return 0;
+
+  long dt_us = (timestamp_ns - rec->last_ns) / 1000;
+  rec->last_ns += dt_us * 1000;
+  write_varint(rec->file, dt_us > 0 ? (uint32_t)dt_us : 0);
+
+  for (int bar = 0; bar < rec->bar_count; bar++) {
+    float m = bar < bar_count ? clamp(magnitudes[bar], 0.0f, 1.0f) : 0.0f;
+    int q = (int)(m * QUANT_LEVELS + 0.5f);
+    write_varint(rec->file, zigzag(q - rec->prev[bar]));
+    rec->prev[bar] = q;
+  }
+
+  return !ferror(rec->file);
+}
+
+// Flush and close a recording
+void record_close(recorder_t *rec) {
+  if (!rec)
+    return;
+
+  if (rec->file)
+    fclose(rec->file);
+  free(rec->prev);
+  free(rec);
+}
+
+// Read and check the renderer settings of the header into config
+static int read_header(FILE *f, config_t *config) {
+  return read_int(f, &config->bar_count, 1, MAX_BARS) &&
+         read_int(f, &config->fps, 1, MAX_FPS) &&
+         read_int(f, &config->use_colors, 0, 1) &&
+         read_int(f, &config->gradient_mode, 0, 2) &&
+         read_int(f, &config->orientation, 0, 2) &&
+         read_int(f, &config->reverse, 0, 1) &&
+         read_int(f, &config->bar_width, 1, MAX_BAR_WIDTH) &&
+         read_int(f, &config->bar_spacing, 0, MAX_BAR_WIDTH) &&
+         read_string(f, config->bar_char, sizeof(config->bar_char)) &&
+         read_string(f, config->color_low, sizeof(config->color_low)) &&
+         read_string(f, config->color_mid, sizeof(config->color_mid)) &&
+         read_string(f, config->color_high, sizeof(config->color_high));
+}
+
+// Open a recording for replay: config gets the defaults and the recorded
+// renderer settings
+replayer_t *replay_open(const char *filename, config_t *config) {
+  replayer_t *rp = calloc(1, sizeof(replayer_t));
+  if (!rp) {
+    fprintf(stderr, "Failed to allocate replayer\n");
+    return NULL;
+  }
+
+  rp->file = fopen(filename, "rb");
+  if (!rp->file) {
+    fprintf(stderr, "Failed to open recording: %s\n", filename);
+    replay_close(rp);
+    return NULL;
+  }
+
+  char magic[8];
+  uint32_t version = 0;
+  if (fread(magic, 1, 8, rp->file) != 8) {
+    fprintf(stderr, "Not a recording: %s\n", filename);
+    replay_close(rp);
+    return NULL;
+  }
+  if (memcmp(magic, RECORD_MAGIC, 8) != 0 || !read_u32(rp->file, &version)) {
+    fprintf(stderr, "Not a recording: %s\n", filename);
+    replay_close(rp);
+    return NULL;
+  }
+  if (version != RECORD_VERSION) {
+    fprintf(stderr, "Unsupported recording version %u: %s\n", version,
+            filename);
+    replay_close(rp);
+    return NULL;
+  }
+
+  config_set_defaults(config);
+  if (!read_header(rp->file, config)) {
+    fprintf(stderr, "Invalid recording header: %s\n", filename);
+    replay_close(rp);
+    return NULL;
+  }
+
+  rp->bar_count = config->bar_count;
+  rp->prev = calloc(rp->bar_count, sizeof(int));
+  if (!rp->prev) {
+    replay_close(rp);
+    return NULL;
+  }
+
+  return rp;
+}
+
+// Decode the next frame; returns 0 at end of file
+int replay_frame(replayer_t *rp, float *magnitudes, int bar_count,
+                 long *timestamp_ns) {
+  if (!rp || !magnitudes)
+    return 0;
+
+  uint32_t dt_us;
+  if (!read_varint(rp->file, &dt_us))
+    return 0;
+  rp->time_ns += (long)dt_us * 1000;
+
+  for (int bar = 0; bar < rp->bar_count; bar++) {
+    uint32_t v;
+    if (!read_varint(rp->file, &v))
+      return 0;
+    rp->prev[bar] += unzigzag(v);
+    if (bar < bar_count)
+      magnitudes[bar] = (float)rp->prev[bar] / QUANT_LEVELS;
+  }
+
+  if (timestamp_ns)
+    *timestamp_ns = rp->time_ns;
+  return 1;
+}
+
+// Close a replay
+void replay_close(replayer_t *rp) {
+  if (!rp)
+    return;
+
+  if (rp->file)
+    fclose(rp->file);
+  free(rp->prev);
+  free(rp);
+}
@@ -1,39 +1,96 @@
 #include "render.h"
+#include "layout.h"
+#include "pool.h"
+#include "render_ansi.h"
+#include "render_headless.h"
+#include "trace.h"
 #include <math.h>
 #include <ncurses.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
-// Color pairs
-#define COLOR_PAIR_LOW 1
-#define COLOR_PAIR_MID 2
-#define COLOR_PAIR_HIGH 3
+// Frame composition threads when render_threads is 0 (auto)
+#define MAX_RENDER_THREADS 4
 
 static int screen_height;
 static int screen_width;
 
-// Map color name to ncurses color
-static int get_color_code(const char *color_name) {
-  if (strcasecmp(color_name, "red") == 0)
-    return COLOR_RED;
-  if (strcasecmp(color_name, "green") == 0)
-    return COLOR_GREEN;
-  if (strcasecmp(color_name, "yellow") == 0)
-    return COLOR_YELLOW;
-  if (strcasecmp(color_name, "blue") == 0)
-    return COLOR_BLUE;
-  if (strcasecmp(color_name, "magenta") == 0)
-    return COLOR_MAGENTA;
-  if (strcasecmp(color_name, "cyan") == 0)
-    return COLOR_CYAN;
-  if (strcasecmp(color_name, "white") == 0)
-    return COLOR_WHITE;
-  return COLOR_WHITE;
+// Selected backend: ncurses, direct ANSI output (render_ansi.c) or an
+// in-memory grid (render_headless.c)
+static int backend;
+
+// Workers composing large frames for the grid backends; ncurses is not
+// thread-safe and always draws on the calling thread
+static worker_pool_t *pool;
+
+// Waterfall history: ring of quantized rows, newest at waterfall_head
+static unsigned char *waterfall;
+static int waterfall_rows;
+static int waterfall_bars;
+static int waterfall_head;
+static int waterfall_count;
+static int waterfall_height; // Screen size the history was painted for
+static int waterfall_width;
+
+// Draw one cell through ncurses
+static void curses_put(canvas_t *canvas, int y, int x, int glyph, int color) {
+  const char *s = glyph == GLYPH_BAR ? (const char *)canvas->data
+                                     : layout_shade_chars[glyph];
+
+  if (color)
+    attron(COLOR_PAIR(color));
+  mvaddstr(y, x, s);
+  if (color)
+    attroff(COLOR_PAIR(color));
+}
+
+static void curses_text(canvas_t *canvas, int y, int x, const char *s,
+                        int max_len, int attr) {
+  (void)canvas;
+  attr_t a = attr == TEXT_BOLD ? A_BOLD : A_DIM;
+
+  attron(a);
+  mvaddnstr(y, x, s, max_len);
+  attroff(a);
+}
+
+// Canvas over stdscr covering the whole screen
+static canvas_t curses_canvas(const config_t *config) {
+  canvas_t canvas = {.put = curses_put,
+                     .text = curses_text,
+                     .data = (void *)config->bar_char};
+  layout_set_area(&canvas, 0, 0, screen_height, screen_width);
+  return canvas;
 }
 
-// Initialize ncurses rendering
+// Start the composition pool: render_threads threads, or one per core
+// up to MAX_RENDER_THREADS; NULL when there is a single thread
+static worker_pool_t *start_pool(const config_t *config) {
+  int threads = config->render_threads;
+  if (threads <= 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cpus < MAX_RENDER_THREADS ? (int)cpus : MAX_RENDER_THREADS;
+  }
+  return threads > 1 ? pool_init(threads) : NULL;
+}
+
+// Initialize rendering
 int render_init(const config_t *config) {
+  backend = config->backend;
+  if (backend == BACKEND_ANSI || backend == BACKEND_HEADLESS) {
+    pool = start_pool(config);
+    int ok = backend == BACKEND_ANSI ? ansi_init(config, pool)
+                                     : headless_init(config, pool);
+    if (!ok) {
+      pool_cleanup(pool);
+      pool = NULL;
+    }
+    return ok;
+  }
+  backend = BACKEND_NCURSES;
+
   initscr();
   cbreak();
   noecho();
@@ -46,132 +103,212 @@ int render_init(const config_t *config) {
     use_default_colors();
 
     // Define color pairs
-    init_pair(COLOR_PAIR_LOW, get_color_code(config->color_low), -1);
-    init_pair(COLOR_PAIR_MID, get_color_code(config->color_mid), -1);
-    init_pair(COLOR_PAIR_HIGH, get_color_code(config->color_high), -1);
+    init_pair(COLOR_PAIR_LOW, layout_color_code(config->color_low), -1);
+    init_pair(COLOR_PAIR_MID, layout_color_code(config->color_mid), -1);
+    init_pair(COLOR_PAIR_HIGH, layout_color_code(config->color_high), -1);
   }
 
   getmaxyx(stdscr, screen_height, screen_width);
 
+  // Waterfall mode scrolls the screen instead of redrawing it
+  if (config->orientation == 2) {
+    scrollok(stdscr, TRUE);
+    idlok(stdscr, TRUE);
+  }
+
   return 1;
 }
 
-// Get color pair based on height and gradient mode
-static int get_color_for_height(float height, int gradient_mode) {
-  if (gradient_mode == 0) {
-    // Solid color
-    return COLOR_PAIR_MID;
-  } else if (gradient_mode == 1) {
-    // Rainbow gradient based on height
-    if (height < 0.33f)
-      return COLOR_PAIR_LOW;
-    if (height < 0.66f)
-      return COLOR_PAIR_MID;
-    return COLOR_PAIR_HIGH;
+// Scrolling spectrogram: scroll one line and paint only the newest row,
+// repainting from the history only after a resize
+static void render_waterfall(const float *magnitudes, int bar_count,
+                             const config_t *config) {
+  canvas_t canvas = curses_canvas(config);
+  int start_x;
+  int bars = layout_bars(bar_count, screen_width, config, &start_x);
+  int rows = screen_height - 1; // Last line holds the controls hint
+  if (rows < 1 || bars < 1)
+    return;
+
+  int repaint = screen_height != waterfall_height ||
+                screen_width != waterfall_width || !waterfall;
+
+  if (rows != waterfall_rows || bars != waterfall_bars || !waterfall) {
+    unsigned char *history = calloc(rows * bars, 1);
+    if (!history)
+      return;
+    free(waterfall);
+    waterfall = history;
+    waterfall_rows = rows;
+    waterfall_bars = bars;
+    waterfall_head = 0;
+    waterfall_count = 0;
+    repaint = 1;
+  }
+
+  // Quantize the new spectrum into the ring
+  waterfall_head = (waterfall_head + 1) % rows;
+  if (waterfall_count < rows)
+    waterfall_count++;
+  unsigned char *newest = waterfall + waterfall_head * bars;
+  for (int i = 0; i < bars; i++)
+    newest[i] = layout_shade(magnitudes[i]);
+
+  // Newest row at the bottom (scrolling up), or at the top when reversed
+  int new_y = config->reverse ? 0 : rows - 1;
+  int step = config->reverse ? 1 : -1;
+
+  if (repaint) {
+    erase();
+    for (int age = 0; age < waterfall_count; age++) {
+      int index = (waterfall_head - age + rows) % rows;
+      layout_draw_waterfall_row(&canvas, new_y + step * age,
+                                waterfall + index * bars, bars, start_x,
+                                config);
+    }
+
+    waterfall_height = screen_height;
+    waterfall_width = screen_width;
   } else {
-    // Custom gradient
-    if (height < 0.5f)
-      return COLOR_PAIR_LOW;
-    return COLOR_PAIR_HIGH;
+    setscrreg(0, rows - 1);
+    scrl(config->reverse ? -1 : 1);
+    layout_draw_waterfall_row(&canvas, new_y, newest, bars, start_x, config);
   }
+
+  // The hint line is outside the scroll region; rewrite it in case the
+  // status changed
+  move(screen_height - 1, 0);
+  clrtoeol();
+  curses_text(&canvas, screen_height - 1, 0, layout_hint(), -1, TEXT_DIM);
+
+  refresh();
 }
 
-// Render a single frame
-void render_frame(const float *magnitudes, int bar_count,
-                  const config_t *config) {
+// Draw a single frame through ncurses
+static void curses_frame(const float *magnitudes, int bar_count,
+                         const config_t *config) {
   // Get current screen size (handle resize)
   getmaxyx(stdscr, screen_height, screen_width);
 
+  if (config->orientation == 2) {
+    render_waterfall(magnitudes, bar_count, config);
+    return;
+  }
+
   // Clear screen
   erase();
 
-  // Calculate bar dimensions
-  int total_bar_width = config->bar_width + config->bar_spacing;
-  int available_width = screen_width;
-  int bars_to_draw = bar_count;
-
-  // Adjust bar count if it doesn't fit
-  if (total_bar_width * bar_count > available_width) {
-    bars_to_draw = available_width / total_bar_width;
-  }
-
-  int start_x = (screen_width - (bars_to_draw * total_bar_width)) / 2;
-  if (start_x < 0)
-    start_x = 0;
-
-  // Draw bars
-  for (int i = 0; i < bars_to_draw; i++) {
-    float magnitude = magnitudes[i];
-
-    // Calculate bar height
-    int bar_height = (int)(magnitude * (screen_height - 2));
-    if (bar_height > screen_height - 1)
-      bar_height = screen_height - 1;
-
-    // Calculate bar position
-    int x = start_x + (i * total_bar_width);
-
-    if (config->orientation == 0) {
-      // Vertical bars
-      int start_y = config->reverse ? 0 : (screen_height - 1 - bar_height);
-      int end_y = config->reverse ? bar_height : (screen_height - 1);
-
-      for (int y = start_y; y <= end_y && y < screen_height; y++) {
-        float height_ratio =
-            (float)(y - start_y) / (bar_height > 0 ? bar_height : 1);
-
-        if (config->use_colors) {
-          int color = get_color_for_height(height_ratio, config->gradient_mode);
-          attron(COLOR_PAIR(color));
-        }
-
-        // Draw bar width
-        for (int w = 0; w < config->bar_width && (x + w) < screen_width; w++) {
-          mvaddstr(y, x + w, config->bar_char);
-        }
-
-        if (config->use_colors) {
-          attroff(COLOR_PAIR(
-              get_color_for_height(height_ratio, config->gradient_mode)));
-        }
-      }
-    } else {
-      // Horizontal bars
-      int bar_y = i * 2; // Spacing for horizontal mode
-      if (bar_y >= screen_height)
-        break;
-
-      int start_x_bar = config->reverse ? (screen_width - 1 - bar_height) : 0;
-      int end_x_bar = config->reverse ? (screen_width - 1) : bar_height;
-
-      for (int x_bar = start_x_bar; x_bar <= end_x_bar && x_bar < screen_width;
-           x_bar++) {
-        float width_ratio =
-            (float)(x_bar - start_x_bar) / (bar_height > 0 ? bar_height : 1);
-
-        if (config->use_colors) {
-          int color = get_color_for_height(width_ratio, config->gradient_mode);
-          attron(COLOR_PAIR(color));
-        }
-
-        mvaddstr(bar_y, x_bar, config->bar_char);
-
-        if (config->use_colors) {
-          attroff(COLOR_PAIR(
-              get_color_for_height(width_ratio, config->gradient_mode)));
-        }
-      }
-    }
-  }
+  canvas_t canvas = curses_canvas(config);
+  layout_draw_bars(&canvas, magnitudes, bar_count, config);
 
   // Display controls hint
-  attron(A_DIM);
-  mvprintw(screen_height - 1, 0, "Press 'q' to quit");
-  attroff(A_DIM);
+  curses_text(&canvas, screen_height - 1, 0, layout_hint(), -1, TEXT_DIM);
 
   // Refresh screen
   refresh();
 }
 
-// Cleanup ncurses
-void render_cleanup(void) { endwin(); }
+// Draw several sources tiled in a near-square grid through ncurses
+static void curses_panels(const float *const *magnitudes,
+                          const char *const *labels, int panels,
+                          int bar_count, const config_t *config) {
+  getmaxyx(stdscr, screen_height, screen_width);
+  if (panels < 1)
+    return;
+
+  // Writing the bottom-right cell must not scroll the wall
+  scrollok(stdscr, FALSE);
+
+  erase();
+
+  canvas_t canvas = curses_canvas(config);
+  layout_draw_panels(&canvas, magnitudes, labels, panels, bar_count,
+                     screen_height, screen_width, config);
+
+  refresh();
+}
+
+// Render a single frame
+void render_frame(const float *magnitudes, int bar_count,
+                  const config_t *config) {
+  long trace_start = trace_begin();
+  if (backend == BACKEND_ANSI)
+    ansi_frame(magnitudes, bar_count, config);
+  else if (backend == BACKEND_HEADLESS)
+    headless_frame(magnitudes, bar_count, config);
+  else
+    curses_frame(magnitudes, bar_count, config);
+  trace_end("render_frame", trace_start);
+}
+
+// Render one frame of several sources tiled in a near-square grid
+void render_panels(const float *const *magnitudes, const char *const *labels,
+                   int panels, int bar_count, const config_t *config) {
+  long trace_start = trace_begin();
+  if (backend == BACKEND_ANSI)
+    ansi_panels(magnitudes, labels, panels, bar_count, config);
+  else if (backend == BACKEND_HEADLESS)
+    headless_panels(magnitudes, labels, panels, bar_count, config);
+  else
+    curses_panels(magnitudes, labels, panels, bar_count, config);
+  trace_end("render_panels", trace_start);
+}
+
+// Show a status (e.g. reduced quality) after the controls hint, NULL to
+// clear it
+void render_status(const char *status) { layout_set_status(status); }
+
+// Read one key without blocking (ERR if none)
+int render_getch(void) {
+  if (backend == BACKEND_ANSI)
+    return ansi_getch();
+  if (backend == BACKEND_HEADLESS)
+    return ERR; // No keyboard
+  return getch();
+}
+
+// File descriptor that becomes readable when a key is waiting, -1 when
+// the backend takes no input
+int render_input_fd(void) {
+  if (backend == BACKEND_HEADLESS)
+    return -1;
+  return STDIN_FILENO;
+}
+
+// Write the last frame's cell grid to path (headless backend only)
+int render_dump(const char *path, const config_t *config) {
+  if (backend != BACKEND_HEADLESS) {
+    fprintf(stderr, "Only the headless backend can dump its screen\n");
+    return -1;
+  }
+
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    fprintf(stderr, "Failed to open dump file: %s\n", path);
+    return -1;
+  }
+
+  int failed = headless_dump(file, config) != 0;
+  if (fclose(file) != 0 || failed) {
+    fprintf(stderr, "Failed to write dump file: %s\n", path);
+    return -1;
+  }
+  return 0;
+}
+
+// Cleanup rendering
+void render_cleanup(void) {
+  if (backend == BACKEND_ANSI || backend == BACKEND_HEADLESS) {
+    if (backend == BACKEND_ANSI)
+      ansi_cleanup();
+    else
+      headless_cleanup();
+    pool_cleanup(pool);
+    pool = NULL;
+    return;
+  }
+
+  free(waterfall);
+  waterfall = NULL;
+  endwin();
+}
@@ -0,0 +1,647 @@
+#include "render_ansi.h"
+#include "layout.h"
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+// Cells in a pre-encoded glyph run, copied with one memcpy
+#define RUN_CELLS 16
+
+// Worst-case output per cell (style change and the longest bar_char) and
+// per row (cursor movement and erase), plus per-frame escapes
+#define CELL_BYTES 24
+#define ROW_BYTES 32
+#define FRAME_BYTES 64
+
+// Unchanged cells worth skipping with a cursor-forward escape instead of
+// writing them again
+#define SKIP_CELLS 6
+
+// Synchronized update (DEC mode 2026): the terminal holds the screen while
+// a frame arrives and shows it at once
+#define SYNC_BEGIN "\x1b[?2026h"
+#define SYNC_END "\x1b[?2026l"
+
+// Alternate screen, hidden cursor and no autowrap while running
+#define SCREEN_ENTER "\x1b[?1049h\x1b[?25l\x1b[?7l"
+#define SCREEN_LEAVE "\x1b[0m\x1b[r\x1b[?7h\x1b[?25h\x1b[?1049l"
+
+// How long the rest of an escape sequence may lag its ESC byte (ms)
+#define ESC_TIMEOUT_MS 25
+
+// Rows per strip when a large frame is encoded across the pool
+#define STRIP_ROWS 8
+
+#define EMIT(o, s) emit(o, s, sizeof(s) - 1)
+
+// One screen cell: a glyph (GLYPH_SPACE to GLYPH_BAR) or a printable ASCII
+// character, and its style (color pair | text attribute << 2)
+typedef struct {
+  uint8_t ch;
+  uint8_t style;
+} cell_t;
+
+static int rows;
+static int cols;
+static cell_t *grid;   // Frame being composed
+static cell_t *shown;  // What the terminal currently displays
+static uint8_t *levels; // Newest waterfall row
+
+// Terminal output being built: the whole frame, or one strip of rows
+// that a pool worker encodes into its own slice of the frame buffer
+typedef struct {
+  char *buf;
+  size_t len;
+  size_t cap;
+  int direct;   // May write to the terminal early when full (frame only)
+  int overflow; // A strip ran out of room and lost output
+
+  // Cursor position and style once buf is written (-1 = unknown)
+  int cursor_y;
+  int cursor_x;
+  int cursor_style;
+} output_t;
+
+// Output of one frame, sized for the screen so frames never grow it
+static output_t frame = {.direct = 1};
+static output_t *strips; // One per STRIP_ROWS rows
+static int strip_count;
+static worker_pool_t *pool; // Encodes large frames (may be NULL)
+
+// Pre-encoded glyph runs and the SGR sequence of every style
+static char glyph_run[WATERFALL_SHADES][RUN_CELLS * 8];
+static int glyph_len[WATERFALL_SHADES]; // Bytes per cell
+static char sgr[16][16];
+static int sgr_len[16];
+
+static int sync_output;     // Terminal supports synchronized update
+static int clear_pending;   // Screen must be cleared before the next frame
+static int waterfall_valid; // grid holds the previous waterfall frame
+
+static struct termios saved_termios;
+static int termios_saved;
+static struct sigaction saved_winch;
+static volatile sig_atomic_t resized;
+
+static void winch_handler(int sig) {
+  (void)sig;
+  resized = 1;
+}
+
+// Write all of buf to the terminal
+static void write_all(const char *buf, size_t len) {
+  while (len > 0) {
+    ssize_t n = write(STDOUT_FILENO, buf, len);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return;
+    }
+    buf += n;
+    len -= n;
+  }
+}
+
+static void emit(output_t *o, const char *s, size_t n) {
+  // The buffer is sized for a full repaint; flush early rather than drop
+  // output should a frame ever exceed it. A strip cannot write out of
+  // order, so it records the loss instead.
+  if (o->len + n > o->cap) {
+    if (!o->direct) {
+      o->overflow = 1;
+      return;
+    }
+    write_all(o->buf, o->len);
+    o->len = 0;
+    if (n > o->cap) {
+      write_all(s, n);
+      return;
+    }
+  }
+  memcpy(o->buf + o->len, s, n);
+  o->len += n;
+}
+
+static void emit_style(output_t *o, int style) {
+  if (o->cursor_style == style)
+    return;
+  emit(o, sgr[style], sgr_len[style]);
+  o->cursor_style = style;
+}
+
+// Move the cursor, forward on the same line if possible
+static void emit_move(output_t *o, int y, int x) {
+  if (o->cursor_y == y && o->cursor_x == x)
+    return;
+
+  char seq[24];
+  int n;
+  if (o->cursor_y == y && o->cursor_x >= 0 && x > o->cursor_x)
+    n = snprintf(seq, sizeof(seq), "\x1b[%dC", x - o->cursor_x);
+  else
+    n = snprintf(seq, sizeof(seq), "\x1b[%d;%dH", y + 1, x + 1);
+  emit(o, seq, n);
+  o->cursor_y = y;
+  o->cursor_x = x;
+}
+
+// Write cells [x, end) of a row, one memcpy per run of equal glyphs
+static void emit_cells(output_t *o, const cell_t *row, int x, int end) {
+  while (x < end) {
+    cell_t c = row[x];
+    emit_style(o, c.style);
+
+    if (c.ch < WATERFALL_SHADES) {
+      int n = 1;
+      while (x + n < end && n < RUN_CELLS && row[x + n].ch == c.ch &&
+             row[x + n].style == c.style)
+        n++;
+      emit(o, glyph_run[c.ch], n * glyph_len[c.ch]);
+      x += n;
+    } else {
+      emit(o, (const char *)&c.ch, 1);
+      x++;
+    }
+  }
+
+  // Autowrap is off, so the cursor stays on the last column
+  o->cursor_x = end < cols ? end : -1;
+}
+
+static int same_cell(cell_t a, cell_t b) {
+  return a.ch == b.ch && a.style == b.style;
+}
+
+// Columns up to the last non-blank cell
+static int row_end(const cell_t *row) {
+  int end = cols;
+  while (end > 0 && row[end - 1].ch == GLYPH_SPACE)
+    end--;
+  return end;
+}
+
+// Bring one terminal row up to date with the grid: write the changed
+// spans (short unchanged gaps are rewritten, long ones skipped) and erase
+// what is left of the old content past the new end
+static void emit_row(output_t *o, int y) {
+  const cell_t *now = grid + y * cols;
+  cell_t *was = shown + y * cols;
+  if (memcmp(now, was, cols * sizeof(cell_t)) == 0)
+    return;
+
+  int now_end = row_end(now);
+  int was_end = row_end(was);
+  int x = 0;
+
+  while (x < now_end) {
+    if (same_cell(now[x], was[x])) {
+      x++;
+      continue;
+    }
+
+    int end = x + 1;
+    for (int i = end; i < now_end && i - end < SKIP_CELLS; i++) {
+      if (!same_cell(now[i], was[i]))
+        end = i + 1;
+    }
+
+    emit_move(o, y, x);
+    emit_cells(o, now, x, end);
+    x = end;
+  }
+
+  if (was_end > now_end) {
+    emit_move(o, y, now_end);
+    emit_style(o, 0);
+    EMIT(o, "\x1b[K");
+  }
+
+  memcpy(was, now, cols * sizeof(cell_t));
+}
+
+// Size the grids and the output buffer for the terminal; on a change the
+// next frame repaints from a cleared screen
+static int resize_screen(void) {
+  struct winsize ws;
+  int new_rows = 24;
+  int new_cols = 80;
+  if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0 &&
+      ws.ws_col > 0) {
+    new_rows = ws.ws_row;
+    new_cols = ws.ws_col;
+  }
+
+  if (grid && new_rows == rows && new_cols == cols)
+    return 0;
+
+  free(grid);
+  free(shown);
+  free(levels);
+  free(frame.buf);
+  free(strips);
+  rows = new_rows;
+  cols = new_cols;
+  grid = calloc((size_t)rows * cols, sizeof(cell_t));
+  shown = calloc((size_t)rows * cols, sizeof(cell_t));
+  levels = malloc(cols);
+  frame.cap = (size_t)rows * cols * CELL_BYTES + rows * ROW_BYTES + FRAME_BYTES;
+  frame.buf = malloc(frame.cap);
+  strip_count = (rows + STRIP_ROWS - 1) / STRIP_ROWS;
+  strips = calloc(strip_count, sizeof(output_t));
+
+  if (!grid || !shown || !levels || !frame.buf || !strips) {
+    free(grid);
+    free(shown);
+    free(levels);
+    free(frame.buf);
+    free(strips);
+    grid = shown = NULL;
+    levels = NULL;
+    frame.buf = NULL;
+    frame.cap = 0;
+    strips = NULL;
+    return -1;
+  }
+
+  clear_pending = 1;
+  waterfall_valid = 1; // Both grids start blank
+  return 0;
+}
+
+// Start a frame in the output buffer
+static int begin_frame(void) {
+  if (resized || !grid) {
+    resized = 0;
+    if (resize_screen() != 0)
+      return -1;
+  }
+
+  frame.len = 0;
+  if (sync_output)
+    EMIT(&frame, SYNC_BEGIN);
+
+  if (clear_pending) {
+    EMIT(&frame, "\x1b[0m\x1b[2J");
+    frame.cursor_style = 0;
+    frame.cursor_y = -1;
+    frame.cursor_x = -1;
+    clear_pending = 0;
+  }
+  return 0;
+}
+
+static void encode_strip(void *arg, int index) {
+  (void)arg;
+  int first = index * STRIP_ROWS;
+  int last = first + STRIP_ROWS < rows ? first + STRIP_ROWS : rows;
+
+  for (int y = first; y < last; y++)
+    emit_row(&strips[index], y);
+}
+
+// Encode strips of rows across the pool, each into its own slice of the
+// frame buffer sized for a full repaint of its rows, then close the gaps
+// between the slices in order. Only the first strip knows where the
+// cursor is; the others start with an absolute move and a style.
+static void encode_parallel(void) {
+  size_t row_bytes = (size_t)cols * CELL_BYTES + ROW_BYTES;
+
+  for (int i = 0; i < strip_count; i++) {
+    output_t *strip = &strips[i];
+    int first = i * STRIP_ROWS;
+    int count = first + STRIP_ROWS < rows ? STRIP_ROWS : rows - first;
+    strip->buf = frame.buf + frame.len + first * row_bytes;
+    strip->len = 0;
+    strip->cap = count * row_bytes;
+    strip->overflow = 0;
+    strip->cursor_y = i == 0 ? frame.cursor_y : -1;
+    strip->cursor_x = i == 0 ? frame.cursor_x : -1;
+    strip->cursor_style = i == 0 ? frame.cursor_style : -1;
+  }
+
+  pool_run(pool, encode_strip, NULL, strip_count);
+
+  int overflow = 0;
+  for (int i = 0; i < strip_count; i++) {
+    output_t *strip = &strips[i];
+    overflow |= strip->overflow;
+    if (strip->len == 0)
+      continue;
+
+    memmove(frame.buf + frame.len, strip->buf, strip->len);
+    frame.len += strip->len;
+    frame.cursor_y = strip->cursor_y;
+    frame.cursor_x = strip->cursor_x;
+    frame.cursor_style = strip->cursor_style;
+  }
+
+  // Cannot happen with the worst-case sizing, but should a strip lose
+  // output, repaint everything from a cleared screen next frame
+  if (overflow) {
+    memset(shown, 0, (size_t)rows * cols * sizeof(cell_t));
+    clear_pending = 1;
+  }
+}
+
+// Diff the grid against the screen and write the frame with one write()
+static void end_frame(void) {
+  if (pool && rows * cols >= LAYOUT_PARALLEL_CELLS) {
+    encode_parallel();
+  } else {
+    for (int y = 0; y < rows; y++)
+      emit_row(&frame, y);
+  }
+
+  if (sync_output)
+    EMIT(&frame, SYNC_END);
+  write_all(frame.buf, frame.len);
+}
+
+static void grid_put(canvas_t *canvas, int y, int x, int glyph, int color) {
+  (void)canvas;
+  if (y < 0 || y >= rows || x < 0 || x >= cols)
+    return;
+
+  cell_t *cell = grid + y * cols + x;
+  cell->ch = glyph;
+  cell->style = glyph == GLYPH_SPACE ? 0 : color;
+}
+
+static void grid_text(canvas_t *canvas, int y, int x, const char *s,
+                      int max_len, int attr) {
+  (void)canvas;
+  if (y < 0 || y >= rows)
+    return;
+
+  for (int i = 0; s[i] && (max_len < 0 || i < max_len) && x + i < cols; i++) {
+    if (x + i < 0)
+      continue;
+
+    unsigned char ch = s[i];
+    cell_t *cell = grid + y * cols + x + i;
+    if (ch == ' ') {
+      cell->ch = GLYPH_SPACE;
+      cell->style = 0;
+    } else {
+      cell->ch = ch > ' ' && ch < 127 ? ch : '?';
+      cell->style = attr << 2;
+    }
+  }
+}
+
+static canvas_t grid_canvas(void) {
+  canvas_t canvas = {.put = grid_put, .text = grid_text, .pool = pool};
+  layout_set_area(&canvas, 0, 0, rows, cols);
+  return canvas;
+}
+
+// Ask the terminal whether it knows DEC mode 2026. The DA1 query that
+// follows is answered by every terminal, so its reply ends the wait even
+// when the mode query is ignored.
+static int query_sync(void) {
+  EMIT(&frame, "\x1b[?2026$p\x1b[c");
+  write_all(frame.buf, frame.len);
+  frame.len = 0;
+
+  char reply[256];
+  size_t len = 0;
+  int supported = 0;
+  int answered = 0;
+  struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+
+  while (!answered && len < sizeof(reply) - 1 && poll(&pfd, 1, 200) > 0) {
+    ssize_t n = read(STDIN_FILENO, reply + len, sizeof(reply) - 1 - len);
+    if (n <= 0)
+      break;
+    len += n;
+    reply[len] = '\0';
+
+    // DECRPM is CSI ? 2026 ; Ps $ y with Ps 1 (set) or 2 (reset)
+    const char *mode = strstr(reply, "\x1b[?2026;");
+    if (mode && (mode[8] == '1' || mode[8] == '2') && mode[9] == '$')
+      supported = 1;
+
+    // DA1 is CSI ? Ps ; ... c
+    for (const char *p = reply; (p = strstr(p, "\x1b[?")); p += 3) {
+      const char *q = p + 3;
+      while ((*q >= '0' && *q <= '9') || *q == ';')
+        q++;
+      if (*q == 'c')
+        answered = 1;
+    }
+  }
+
+  return supported;
+}
+
+// Pre-encode glyph runs and the SGR sequence of every style
+static void encode_glyphs(const config_t *config) {
+  for (int g = 0; g < WATERFALL_SHADES; g++) {
+    const char *s = g == GLYPH_BAR ? config->bar_char : layout_shade_chars[g];
+    int len = strlen(s);
+    if (len == 0 || len > 8) {
+      s = " ";
+      len = 1;
+    }
+    for (int i = 0; i < RUN_CELLS; i++)
+      memcpy(glyph_run[g] + i * len, s, len);
+    glyph_len[g] = len;
+  }
+
+  int color_codes[4] = {0, layout_color_code(config->color_low),
+                        layout_color_code(config->color_mid),
+                        layout_color_code(config->color_high)};
+
+  for (int style = 0; style < 16; style++) {
+    int color = style & 3;
+    int attr = style >> 2;
+    int n = snprintf(sgr[style], sizeof(sgr[style]), "\x1b[0%s%s",
+                     attr & TEXT_BOLD ? ";1" : "", attr & TEXT_DIM ? ";2" : "");
+    if (color && config->use_colors)
+      n += snprintf(sgr[style] + n, sizeof(sgr[style]) - n, ";3%d",
+                    color_codes[color]);
+    n += snprintf(sgr[style] + n, sizeof(sgr[style]) - n, "m");
+    sgr_len[style] = n;
+  }
+}
+
+// Initialize direct terminal output; large frames are composed and
+// encoded across workers (NULL to do it all on the calling thread)
+int ansi_init(const config_t *config, worker_pool_t *workers) {
+  if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) {
+    fprintf(stderr, "The ANSI backend needs a terminal\n");
+    return 0;
+  }
+
+  if (tcgetattr(STDIN_FILENO, &saved_termios) != 0) {
+    fprintf(stderr, "Failed to read terminal settings\n");
+    return 0;
+  }
+
+  // Unbuffered input without echo; read() returns at once (no key = 0)
+  struct termios raw = saved_termios;
+  raw.c_lflag &= ~(ICANON | ECHO);
+  raw.c_cc[VMIN] = 0;
+  raw.c_cc[VTIME] = 0;
+  tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+  termios_saved = 1;
+
+  struct sigaction sa = {.sa_handler = winch_handler};
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGWINCH, &sa, &saved_winch);
+
+  pool = workers;
+  encode_glyphs(config);
+  if (resize_screen() != 0) {
+    fprintf(stderr, "Failed to allocate screen buffers\n");
+    ansi_cleanup();
+    return 0;
+  }
+
+  sync_output = query_sync();
+
+  write_all(SCREEN_ENTER, sizeof(SCREEN_ENTER) - 1);
+  return 1;
+}
+
+// Scrolling spectrogram: scroll the terminal by one line and diff only
+// the newest row. Scrolling the grid and the shown copy in step keeps the
+// rest of the history from being written again.
+static void draw_waterfall(const float *magnitudes, int bar_count,
+                           const config_t *config) {
+  canvas_t canvas = grid_canvas();
+  int start_x;
+  int bars = layout_bars(bar_count, cols, config, &start_x);
+  int history = rows - 1; // Last line holds the controls hint
+  size_t row_size = cols * sizeof(cell_t);
+
+  if (history >= 1 && bars >= 1) {
+    int new_y = config->reverse ? 0 : history - 1;
+
+    if (!waterfall_valid) {
+      memset(grid, 0, rows * row_size);
+    } else {
+      cell_t *from = config->reverse ? grid : grid + cols;
+      cell_t *to = config->reverse ? grid + cols : grid;
+      memmove(to, from, (history - 1) * row_size);
+      memset(grid + new_y * cols, 0, row_size);
+
+      from = config->reverse ? shown : shown + cols;
+      to = config->reverse ? shown + cols : shown;
+      memmove(to, from, (history - 1) * row_size);
+      memset(shown + new_y * cols, 0, row_size);
+
+      // Scroll region over the history; setting it homes the cursor
+      char seq[32];
+      emit_style(&frame, 0);
+      int n = snprintf(seq, sizeof(seq), "\x1b[1;%dr%s\x1b[r", history,
+                       config->reverse ? "\x1b[T" : "\x1b[S");
+      emit(&frame, seq, n);
+      frame.cursor_y = 0;
+      frame.cursor_x = 0;
+    }
+
+    for (int i = 0; i < bars; i++)
+      levels[i] = layout_shade(magnitudes[i]);
+    layout_draw_waterfall_row(&canvas, new_y, levels, bars, start_x, config);
+    waterfall_valid = 1;
+  }
+
+  grid_text(&canvas, rows - 1, 0, layout_hint(), -1, TEXT_DIM);
+}
+
+// Render a single frame
+void ansi_frame(const float *magnitudes, int bar_count,
+                const config_t *config) {
+  if (begin_frame() != 0)
+    return;
+
+  if (config->orientation == 2) {
+    draw_waterfall(magnitudes, bar_count, config);
+  } else {
+    memset(grid, 0, (size_t)rows * cols * sizeof(cell_t));
+    canvas_t canvas = grid_canvas();
+    layout_draw_bars(&canvas, magnitudes, bar_count, config);
+    grid_text(&canvas, rows - 1, 0, layout_hint(), -1, TEXT_DIM);
+    waterfall_valid = 0;
+  }
+
+  end_frame();
+}
+
+// Render one frame of several sources tiled in a near-square grid
+void ansi_panels(const float *const *magnitudes, const char *const *labels,
+                 int panels, int bar_count, const config_t *config) {
+  if (begin_frame() != 0)
+    return;
+
+  memset(grid, 0, (size_t)rows * cols * sizeof(cell_t));
+  canvas_t canvas = grid_canvas();
+  layout_draw_panels(&canvas, magnitudes, labels, panels, bar_count, rows,
+                     cols, config);
+  waterfall_valid = 0;
+
+  end_frame();
+}
+
+// Read one byte, waiting up to timeout_ms for it (-1 if none)
+static int read_byte(int timeout_ms) {
+  struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+  unsigned char ch;
+  if (timeout_ms > 0 && poll(&pfd, 1, timeout_ms) <= 0)
+    return -1;
+  return read(STDIN_FILENO, &ch, 1) == 1 ? ch : -1;
+}
+
+// Read one key without blocking (-1 if none, like ncurses ERR). Escape
+// sequences are consumed whole and ignored: terminal replies that arrive
+// after query_sync() gave up, and keys such as arrows, must not read as a
+// lone ESC (quit).
+int ansi_getch(void) {
+  int ch = read_byte(0);
+  if (ch != 0x1b)
+    return ch;
+
+  int next = read_byte(ESC_TIMEOUT_MS);
+  if (next < 0)
+    return 0x1b; // Nothing follows: the Escape key itself
+
+  if (next == '[') {
+    // CSI: parameter and intermediate bytes up to a final byte
+    int c;
+    while ((c = read_byte(ESC_TIMEOUT_MS)) >= 0 && (c < 0x40 || c > 0x7e))
+      ;
+  } else if (next == 'O') {
+    read_byte(ESC_TIMEOUT_MS); // SS3: one final byte
+  }
+  return -1;
+}
+
+// Restore the terminal
+void ansi_cleanup(void) {
+  if (termios_saved) {
+    write_all(SCREEN_LEAVE, sizeof(SCREEN_LEAVE) - 1);
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved_termios);
+    sigaction(SIGWINCH, &saved_winch, NULL);
+    termios_saved = 0;
+  }
+
+  free(grid);
+  free(shown);
+  free(levels);
+  free(frame.buf);
+  free(strips);
+  grid = shown = NULL;
+  levels = NULL;
+  frame.buf = NULL;
+  frame.cap = 0;
+  strips = NULL;
+  pool = NULL;
+}
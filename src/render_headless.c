@@ -0,0 +1,214 @@
+#include "render_headless.h"
+#include "layout.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_ROWS 24
+#define DEFAULT_COLS 80
+
+// One cell: a glyph (GLYPH_SPACE to GLYPH_BAR) or a printable ASCII
+// character, its color pair and its text attribute
+typedef struct {
+  uint8_t ch;
+  uint8_t color;
+  uint8_t attr;
+} cell_t;
+
+static int rows;
+static int cols;
+static cell_t *grid;
+static uint8_t *levels; // Newest waterfall row
+static int waterfall_valid; // grid holds the previous waterfall frame
+static worker_pool_t *pool; // Composes large frames (may be NULL)
+
+static void grid_put(canvas_t *canvas, int y, int x, int glyph, int color) {
+  (void)canvas;
+  if (y < 0 || y >= rows || x < 0 || x >= cols)
+    return;
+
+  cell_t *cell = grid + y * cols + x;
+  cell->ch = glyph;
+  cell->color = glyph == GLYPH_SPACE ? 0 : color;
+  cell->attr = 0;
+}
+
+static void grid_text(canvas_t *canvas, int y, int x, const char *s,
+                      int max_len, int attr) {
+  (void)canvas;
+  if (y < 0 || y >= rows)
+    return;
+
+  for (int i = 0; s[i] && (max_len < 0 || i < max_len) && x + i < cols; i++) {
+    if (x + i < 0)
+      continue;
+
+    unsigned char ch = s[i];
+    cell_t *cell = grid + y * cols + x + i;
+    cell->color = 0;
+    if (ch == ' ') {
+      cell->ch = GLYPH_SPACE;
+      cell->attr = 0;
+    } else {
+      cell->ch = ch > ' ' && ch < 127 ? ch : '?';
+      cell->attr = attr;
+    }
+  }
+}
+
+static canvas_t grid_canvas(void) {
+  canvas_t canvas = {.put = grid_put, .text = grid_text, .pool = pool};
+  layout_set_area(&canvas, 0, 0, rows, cols);
+  return canvas;
+}
+
+// Positive integer from the environment, or fallback
+static int env_size(const char *name, int fallback) {
+  const char *value = getenv(name);
+  int n = value ? atoi(value) : 0;
+  return n > 0 ? n : fallback;
+}
+
+// Allocate the grid at $COLUMNS x $LINES; large frames are composed
+// across workers (NULL to draw on the calling thread)
+int headless_init(const config_t *config, worker_pool_t *workers) {
+  (void)config;
+  pool = workers;
+  rows = env_size("LINES", DEFAULT_ROWS);
+  cols = env_size("COLUMNS", DEFAULT_COLS);
+
+  grid = calloc((size_t)rows * cols, sizeof(cell_t));
+  levels = malloc(cols);
+  if (!grid || !levels) {
+    fprintf(stderr, "Failed to allocate %dx%d headless grid\n", cols, rows);
+    headless_cleanup();
+    return 0;
+  }
+
+  waterfall_valid = 1; // The grid starts blank
+  return 1;
+}
+
+// Scrolling spectrogram: move the history one line and draw the newest
+// row, as a terminal would after a scroll
+static void draw_waterfall(const float *magnitudes, int bar_count,
+                           const config_t *config) {
+  canvas_t canvas = grid_canvas();
+  int start_x;
+  int bars = layout_bars(bar_count, cols, config, &start_x);
+  int history = rows - 1; // Last line holds the controls hint
+  size_t row_size = cols * sizeof(cell_t);
+
+  if (history >= 1 && bars >= 1) {
+    int new_y = config->reverse ? 0 : history - 1;
+
+    if (!waterfall_valid) {
+      memset(grid, 0, rows * row_size);
+    } else {
+      cell_t *from = config->reverse ? grid : grid + cols;
+      cell_t *to = config->reverse ? grid + cols : grid;
+      memmove(to, from, (history - 1) * row_size);
+      memset(grid + new_y * cols, 0, row_size);
+    }
+
+    for (int i = 0; i < bars; i++)
+      levels[i] = layout_shade(magnitudes[i]);
+    layout_draw_waterfall_row(&canvas, new_y, levels, bars, start_x, config);
+    waterfall_valid = 1;
+  }
+
+  memset(grid + (rows - 1) * cols, 0, row_size);
+  grid_text(&canvas, rows - 1, 0, layout_hint(), -1, TEXT_DIM);
+}
+
+// Render a single frame into the grid
+void headless_frame(const float *magnitudes, int bar_count,
+                    const config_t *config) {
+  if (!grid)
+    return;
+
+  if (config->orientation == 2) {
+    draw_waterfall(magnitudes, bar_count, config);
+    return;
+  }
+
+  memset(grid, 0, (size_t)rows * cols * sizeof(cell_t));
+  canvas_t canvas = grid_canvas();
+  layout_draw_bars(&canvas, magnitudes, bar_count, config);
+  grid_text(&canvas, rows - 1, 0, layout_hint(), -1, TEXT_DIM);
+  waterfall_valid = 0;
+}
+
+// Render several sources tiled in a near-square grid
+void headless_panels(const float *const *magnitudes,
+                     const char *const *labels, int panels, int bar_count,
+                     const config_t *config) {
+  if (!grid)
+    return;
+
+  memset(grid, 0, (size_t)rows * cols * sizeof(cell_t));
+  canvas_t canvas = grid_canvas();
+  layout_draw_panels(&canvas, magnitudes, labels, panels, bar_count, rows,
+                     cols, config);
+  waterfall_valid = 0;
+}
+
+// Columns up to the last non-blank cell
+static int row_end(const cell_t *row) {
+  int end = cols;
+  while (end > 0 && row[end - 1].ch == GLYPH_SPACE)
+    end--;
+  return end;
+}
+
+// Write the grid as text: a header, the glyphs of every row, then the
+// same rows with one style character per cell ('.' blank, '0'-'3' color
+// pair of a glyph, 'd' dim or 'b' bold text). Trailing blanks are left
+// out so dumps diff cleanly.
+int headless_dump(FILE *file, const config_t *config) {
+  if (!grid)
+    return -1;
+
+  fprintf(file, "grid %dx%d\n", cols, rows);
+  for (int y = 0; y < rows; y++) {
+    const cell_t *row = grid + y * cols;
+    int end = row_end(row);
+    for (int x = 0; x < end; x++) {
+      if (row[x].ch == GLYPH_BAR)
+        fputs(config->bar_char, file);
+      else if (row[x].ch < WATERFALL_SHADES)
+        fputs(layout_shade_chars[row[x].ch], file);
+      else
+        fputc(row[x].ch, file);
+    }
+    fputc('\n', file);
+  }
+
+  fprintf(file, "styles\n");
+  for (int y = 0; y < rows; y++) {
+    const cell_t *row = grid + y * cols;
+    int end = row_end(row);
+    for (int x = 0; x < end; x++) {
+      const cell_t *cell = &row[x];
+      if (cell->ch == GLYPH_SPACE)
+        fputc('.', file);
+      else if (cell->attr == TEXT_BOLD)
+        fputc('b', file);
+      else if (cell->attr == TEXT_DIM)
+        fputc('d', file);
+      else
+        fputc('0' + cell->color, file);
+    }
+    fputc('\n', file);
+  }
+
+  return ferror(file) ? -1 : 0;
+}
+
+void headless_cleanup(void) {
+  free(grid);
+  free(levels);
+  grid = NULL;
+  levels = NULL;
+  pool = NULL;
+}
@@ -0,0 +1,190 @@
+#include "sdft.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Each bar uses three resonators (centre and +/- one bin) so the Hann
+// window can be applied in the frequency domain
+#define RESONATORS_PER_BAR 3
+
+// Damping keeps the recursive update stable against float round-off
+#define SDFT_DAMPING 0.99999f
+
+// Sliding DFT context structure
+struct sdft_context {
+  int sample_rate;
+  int num_bars;
+  int num_resonators;
+
+  // Per-resonator state, stored as separate arrays so the update loop
+  // vectorizes
+  float *coef_re; // r * e^(jw)
+  float *coef_im;
+  float *comb_re; // r^N * e^(jwN)
+  float *comb_im;
+  float *state_re;
+  float *state_im;
+  int *length; // Window length N of the resonator's bar
+
+  // Per-bar power gain (bass boost and window length), folded in at read
+  // time
+  float *gain;
+
+  // Shared delay line holding the last samples (power of two size)
+  float *delay;
+  int delay_mask;
+  int delay_pos;
+};
+
+// Initialize the sliding DFT bank: per bar, a band-centred bin and its
+// two neighbours
+sdft_context_t *sdft_init(int sample_rate, int buffer_size,
+                          const config_t *config) {
+  sdft_context_t *ctx = calloc(1, sizeof(sdft_context_t));
+  if (!ctx) {
+    fprintf(stderr, "Failed to allocate SDFT context\n");
+    return NULL;
+  }
+
+  int bars = config->bar_count;
+  int n = bars * RESONATORS_PER_BAR;
+
+  ctx->sample_rate = sample_rate;
+  ctx->num_bars = bars;
+  ctx->num_resonators = n;
+
+  int delay_size = 1;
+  while (delay_size < buffer_size + 1)
+    delay_size <<= 1;
+  ctx->delay_mask = delay_size - 1;
+
+  ctx->coef_re = calloc(n, sizeof(float));
+  ctx->coef_im = calloc(n, sizeof(float));
+  ctx->comb_re = calloc(n, sizeof(float));
+  ctx->comb_im = calloc(n, sizeof(float));
+  ctx->state_re = calloc(n, sizeof(float));
+  ctx->state_im = calloc(n, sizeof(float));
+  ctx->length = calloc(n, sizeof(int));
+  ctx->gain = calloc(bars, sizeof(float));
+  ctx->delay = calloc(delay_size, sizeof(float));
+
+  if (!ctx->coef_re || !ctx->coef_im || !ctx->comb_re || !ctx->comb_im ||
+      !ctx->state_re || !ctx->state_im || !ctx->length || !ctx->gain ||
+      !ctx->delay) {
+    fprintf(stderr, "Failed to allocate SDFT buffers\n");
+    sdft_cleanup(ctx);
+    return NULL;
+  }
+
+  // Same logarithmic band layout as the FFT binning
+  float freq_per_bin = (float)sample_rate / buffer_size;
+  float nyquist = sample_rate / 2.0f;
+  float log_min = logf(fmaxf(1.0f, (float)config->min_freq));
+  float log_max = logf((float)config->max_freq);
+  float log_range = log_max - log_min;
+
+  for (int bar = 0; bar < bars; bar++) {
+    float lo = expf(log_min + (log_range * bar) / bars);
+    float hi = expf(log_min + (log_range * (bar + 1)) / bars);
+    if (hi > nyquist)
+      hi = nyquist;
+    float centre = sqrtf(lo * hi);
+
+    // Shorter windows for wide bands so one bin covers the whole band
+    float bins = (hi - lo) / freq_per_bin;
+    int length = bins > 1.0f ? (int)(buffer_size / bins) : buffer_size;
+    if (length < 16)
+      length = 16;
+
+    // A windowed sine peaks at length / 4, so scale power by
+    // (buffer_size / length)^2 to match an FFT bin of the full buffer
+    float boost = (centre < nyquist * 0.1f) ? config->bass_boost : 1.0f;
+    float norm = (float)buffer_size / length;
+    ctx->gain[bar] = boost * boost * norm * norm;
+
+    float spacing = (float)sample_rate / length;
+    for (int k = 0; k < RESONATORS_PER_BAR; k++) {
+      int i = bar * RESONATORS_PER_BAR + k;
+      float freq = centre + spacing * (k - 1);
+      float w = 2.0f * M_PI * freq / sample_rate;
+      float damp = powf(SDFT_DAMPING, (float)length);
+
+      ctx->coef_re[i] = SDFT_DAMPING * cosf(w);
+      ctx->coef_im[i] = SDFT_DAMPING * sinf(w);
+      ctx->comb_re[i] = damp * cosf(w * length);
+      ctx->comb_im[i] = damp * sinf(w * length);
+      ctx->length[i] = length;
+    }
+  }
+
+  return ctx;
+}
+
+// Feed newly captured samples through every resonator
+void sdft_push(sdft_context_t *ctx, const float *samples, int count) {
+  if (!ctx || !samples)
+    return;
+
+  for (int s = 0; s < count; s++) {
+    float x = samples[s];
+    int pos = ctx->delay_pos;
+    ctx->delay[pos] = x;
+
+    // S(n) = r e^(jw) S(n-1) + x(n) - r^N e^(jwN) x(n-N)
+    for (int i = 0; i < ctx->num_resonators; i++) {
+      float old = ctx->delay[(pos - ctx->length[i]) & ctx->delay_mask];
+      float re = ctx->state_re[i];
+      float im = ctx->state_im[i];
+
+      ctx->state_re[i] = ctx->coef_re[i] * re - ctx->coef_im[i] * im + x -
+                         ctx->comb_re[i] * old;
+      ctx->state_im[i] =
+          ctx->coef_re[i] * im + ctx->coef_im[i] * re - ctx->comb_im[i] * old;
+    }
+
+    ctx->delay_pos = (pos + 1) & ctx->delay_mask;
+  }
+}
+
+// Read Hann-windowed band power, comparable to the FFT bin average
+void sdft_read(sdft_context_t *ctx, float *bands, int bar_count) {
+  if (!ctx || !bands)
+    return;
+
+  if (bar_count > ctx->num_bars)
+    bar_count = ctx->num_bars;
+
+  for (int bar = 0; bar < bar_count; bar++) {
+    int i = bar * RESONATORS_PER_BAR;
+
+    // Hann window as a 3-tap kernel: 0.5 X(k) - 0.25 X(k-1) - 0.25 X(k+1)
+    float re = 0.5f * ctx->state_re[i + 1] -
+               0.25f * (ctx->state_re[i] + ctx->state_re[i + 2]);
+    float im = 0.5f * ctx->state_im[i + 1] -
+               0.25f * (ctx->state_im[i] + ctx->state_im[i + 2]);
+
+    bands[bar] = (re * re + im * im) * ctx->gain[bar];
+  }
+}
+
+// Rough per-frame cost in the same units as the FFT estimate in fft.c
+float sdft_cost(int bar_count, int hop) {
+  return 10.0f * RESONATORS_PER_BAR * bar_count * hop;
+}
+
+// Cleanup sliding DFT
+void sdft_cleanup(sdft_context_t *ctx) {
+  if (!ctx)
+    return;
+
+  free(ctx->coef_re);
+  free(ctx->coef_im);
+  free(ctx->comb_re);
+  free(ctx->comb_im);
+  free(ctx->state_re);
+  free(ctx->state_im);
+  free(ctx->length);
+  free(ctx->gain);
+  free(ctx->delay);
+  free(ctx);
+}
@@ -0,0 +1,510 @@
+#include "soak.h"
+#include "journal.h"
+#include "utils.h"
+#include <dirent.h>
+#include <malloc.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Resources are sampled SOAK_SAMPLES times over the run, at least a
+// second apart. The first interval is warm-up: plans, caches and pools
+// settle during it.
+#define SOAK_SAMPLES 20
+#define MIN_INTERVAL_NS 1000000000L
+
+// Frame-time histogram: 16 buckets per octave of nanoseconds up to 2^34
+#define BUCKETS_PER_OCTAVE 16
+#define BUCKETS (34 * BUCKETS_PER_OCTAVE)
+
+// Drift limits against the baseline. Memory may grow by the larger of
+// MEMORY_SLACK bytes and MEMORY_SHARE of the baseline, file descriptors
+// and threads not at all. A frame-time percentile fails once it is both
+// FRAME_RATIO times and FRAME_SLACK_NS above its baseline.
+#define MEMORY_SLACK (1L << 20)
+#define MEMORY_SHARE 0.05
+#define FRAME_RATIO 1.5
+#define FRAME_SLACK_NS 50000L
+
+// Synthetic source: a logarithmic sweep from SWEEP_LOW to SWEEP_HIGH Hz
+// every SWEEP_S seconds over a steady tone and noise, fed in blocks of
+// SYNTH_BLOCK frames like a capture quantum. The last SILENCE_S seconds
+// of every SILENCE_EVERY_S are silent, so the gain control and the gates
+// see silence.
+#define SYNTH_CHANNELS 2
+#define SYNTH_BLOCK 512
+#define SWEEP_LOW 20.0
+#define SWEEP_HIGH 20000.0
+#define SWEEP_S 10.0
+#define TONE_HZ 440.0
+#define SILENCE_EVERY_S 60
+#define SILENCE_S 2
+
+// Audio is fed as fast as it can be written. Idle is measured in wall
+// time, though, so after every SILENCE_EVERY_S seconds of audio (counted
+// in samples, on the first source) feeding pauses for sleep_timer plus
+// IDLE_MARGIN_NS and the loop goes through the idle wait.
+#define IDLE_MARGIN_NS 200000000L
+
+// One resource sample, covering the interval since the previous one
+typedef struct {
+  double elapsed_s;
+  long frames;
+  long rss;    // Resident set (bytes)
+  long heap;   // Heap in use (bytes, -1 if unknown)
+  int fds;     // Open file descriptors
+  int threads; // Threads of the process
+  long p50_ns; // Frame-time percentiles
+  long p99_ns;
+  long max_ns;
+} sample_t;
+
+struct soak {
+  // Fed source, used only by the feeder thread once it runs
+  int sources;
+  int channels;
+  int sample_rate;
+  long fed;       // Frames fed on the first source
+  long next_idle; // Frame count at which feeding pauses next
+  long idle_ns;   // How long it pauses (0: never)
+  int failed;     // atomic: the journal could not be read
+
+  // Synthetic source
+  float *block; // SYNTH_BLOCK x SYNTH_CHANNELS
+  long synth_pos;
+  double sweep_phase;
+  unsigned noise;
+
+  // Journal source, started over at its end
+  const char *journal_path;
+  journal_reader_t *journal;
+
+  // Samples taken so far and the frame times of the current interval,
+  // used only by the main loop
+  sample_t samples[SOAK_SAMPLES + 1];
+  int count;
+  long start_ns;
+  long interval_ns;
+  long duration_ns;
+  long next_sample_ns;
+  long end_ns;
+  long frames;
+  unsigned long histogram[BUCKETS];
+  long max_ns;
+};
+
+// Resident set from /proc/self/statm (-1 if unavailable)
+static long read_rss(void) {
+  FILE *file = fopen("/proc/self/statm", "r");
+  if (!file)
+    return -1;
+
+  long size;
+  long resident;
+  int ok = fscanf(file, "%ld %ld", &size, &resident) == 2;
+  fclose(file);
+  return ok ? resident * sysconf(_SC_PAGESIZE) : -1;
+}
+
+// Bytes allocated through malloc(): small blocks of the main arena and
+// every mmap()ed block (-1 where glibc cannot tell)
+static long read_heap(void) {
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+  struct mallinfo2 info = mallinfo2();
+  return (long)(info.uordblks + info.hblkhd);
+#else
+  return -1;
+#endif
+}
+
+// Open file descriptors, not counting the one reading the directory
+static int count_fds(void) {
+  DIR *dir = opendir("/proc/self/fd");
+  if (!dir)
+    return -1;
+
+  int count = 0;
+  struct dirent *entry;
+  while ((entry = readdir(dir)))
+    if (entry->d_name[0] != '.')
+      count++;
+  closedir(dir);
+  return count - 1;
+}
+
+// Threads from /proc/self/status (-1 if unavailable)
+static int count_threads(void) {
+  FILE *file = fopen("/proc/self/status", "r");
+  if (!file)
+    return -1;
+
+  char line[128];
+  int threads = -1;
+  while (fgets(line, sizeof(line), file))
+    if (sscanf(line, "Threads: %d", &threads) == 1)
+      break;
+  fclose(file);
+  return threads;
+}
+
+static void add_frame_time(soak_t *s, long ns) {
+  int bucket = ns > 1 ? (int)(log2((double)ns) * BUCKETS_PER_OCTAVE) : 0;
+  s->histogram[bucket < BUCKETS ? bucket : BUCKETS - 1]++;
+  if (ns > s->max_ns)
+    s->max_ns = ns;
+}
+
+// Frame time below which a share of the interval's frames fell (upper
+// bucket edge, at most the slowest frame)
+static long frame_percentile(const soak_t *s, long frames, double share) {
+  unsigned long target = (unsigned long)(share * frames);
+  unsigned long seen = 0;
+  for (int i = 0; i < BUCKETS; i++) {
+    seen += s->histogram[i];
+    if (seen > target) {
+      long edge = (long)exp2((double)(i + 1) / BUCKETS_PER_OCTAVE);
+      return edge < s->max_ns ? edge : s->max_ns;
+    }
+  }
+  return s->max_ns;
+}
+
+// Sample the resources and the frame times of the interval, then start
+// the next interval
+static void take_sample(soak_t *s, long now) {
+  sample_t *sample = &s->samples[s->count++];
+  sample->elapsed_s = (now - s->start_ns) / 1e9;
+  sample->frames = s->frames;
+  sample->rss = read_rss();
+  sample->heap = read_heap();
+  sample->fds = count_fds();
+  sample->threads = count_threads();
+  sample->p50_ns = frame_percentile(s, s->frames, 0.50);
+  sample->p99_ns = frame_percentile(s, s->frames, 0.99);
+  sample->max_ns = s->max_ns;
+
+  memset(s->histogram, 0, sizeof(s->histogram));
+  s->max_ns = 0;
+  s->frames = 0;
+}
+
+// Count frames fed on the first source and return when the feeder runs
+// next: at once, or after the idle pause once SILENCE_EVERY_S seconds of
+// audio went by
+static long next_feed(soak_t *s, int source, int frames) {
+  if (source != 0)
+    return 0;
+  s->fed += frames;
+  if (s->fed < s->next_idle)
+    return 0;
+  s->next_idle += (long)SILENCE_EVERY_S * s->sample_rate;
+  return s->idle_ns > 0 ? now_ns() + s->idle_ns : 0;
+}
+
+// Feeder: the next block of the synthetic signal, the same on every
+// source
+static long feed_synthetic(audio_context_t *audio, void *arg) {
+  soak_t *s = arg;
+  double rate = s->sample_rate;
+  double octaves = log2(SWEEP_HIGH / SWEEP_LOW);
+
+  for (int i = 0; i < SYNTH_BLOCK; i++, s->synth_pos++) {
+    double t = s->synth_pos / rate;
+    double f = SWEEP_LOW * exp2(octaves * fmod(t, SWEEP_S) / SWEEP_S);
+    s->sweep_phase = fmod(s->sweep_phase + 2.0 * M_PI * f / rate, 2.0 * M_PI);
+
+    s->noise = s->noise * 1664525u + 1013904223u;
+    float noise = (float)(s->noise >> 8) / (1 << 24) - 0.5f;
+    float tone = (float)sin(2.0 * M_PI * TONE_HZ * t);
+    float sweep = (float)sin(s->sweep_phase);
+    float gain =
+        fmod(t, SILENCE_EVERY_S) >= SILENCE_EVERY_S - SILENCE_S ? 0.0f : 1.0f;
+
+    s->block[i * SYNTH_CHANNELS] = gain * (0.3f * sweep + 0.1f * tone +
+                                           0.05f * noise);
+    s->block[i * SYNTH_CHANNELS + 1] = gain * (0.3f * sweep + 0.05f * noise);
+  }
+
+  for (int i = 0; i < s->sources; i++)
+    audio_feed(audio, i, s->block, SYNTH_BLOCK);
+  return next_feed(s, 0, SYNTH_BLOCK);
+}
+
+// Whether a journalled buffer carries audio for a fed source
+static int usable_block(const soak_t *s, const journal_block_t *block) {
+  return block->source >= 0 && block->source < s->sources &&
+         block->channels == s->channels && block->frames > 0;
+}
+
+// Feeder: the next journalled buffer with audio, starting the journal
+// over at its end; -1 stops feeding if it cannot be read
+static long feed_journal(audio_context_t *audio, void *arg) {
+  soak_t *s = arg;
+  journal_block_t block;
+
+  for (;;) {
+    int status = journal_read(s->journal, &block);
+    if (status < 0) {
+      fprintf(stderr, "Journal damaged: %s\n", s->journal_path);
+      __atomic_store_n(&s->failed, 1, __ATOMIC_RELAXED);
+      return -1;
+    }
+
+    if (status == 0) {
+      int sample_rate;
+      int channels;
+      int sources;
+      journal_reader_close(s->journal);
+      s->journal = journal_reader_open(s->journal_path, &sample_rate,
+                                       &channels, &sources);
+      if (!s->journal) {
+        __atomic_store_n(&s->failed, 1, __ATOMIC_RELAXED);
+        return -1;
+      }
+      continue;
+    }
+
+    if (usable_block(s, &block)) {
+      audio_feed(audio, block.source, block.samples, block.frames);
+      return next_feed(s, block.source, block.frames);
+    }
+  }
+}
+
+// Read a journal through once, so a damaged one or one without audio on
+// the first source fails up front rather than while the loop waits for
+// sound; returns 0 if it is usable
+static int check_journal(soak_t *s) {
+  int sample_rate;
+  journal_reader_t *reader = journal_reader_open(
+      s->journal_path, &sample_rate, &s->channels, &s->sources);
+  if (!reader)
+    return -1;
+  if (s->sources > AUDIO_MAX_SOURCES)
+    s->sources = AUDIO_MAX_SOURCES;
+  s->sample_rate = sample_rate;
+
+  journal_block_t block;
+  long frames = 0;
+  int status;
+  while ((status = journal_read(reader, &block)) > 0)
+    if (usable_block(s, &block) && block.source == 0)
+      frames += block.frames;
+  journal_reader_close(reader);
+
+  if (status < 0) {
+    fprintf(stderr, "Journal damaged: %s\n", s->journal_path);
+    return -1;
+  }
+  if (frames == 0) {
+    fprintf(stderr, "Journal holds no audio: %s\n", s->journal_path);
+    return -1;
+  }
+  return 0;
+}
+
+static void print_samples(const sample_t *samples, int count) {
+  printf("  %8s %9s %8s %8s %4s %4s %8s %8s %8s\n", "time s", "frames",
+         "rss MiB", "heap MiB", "fds", "thr", "p50 us", "p99 us", "max us");
+  for (int i = 0; i < count; i++) {
+    const sample_t *sample = &samples[i];
+    printf("  %8.1f %9ld %8.2f %8.2f %4d %4d %8.1f %8.1f %8.1f\n",
+           sample->elapsed_s, sample->frames, sample->rss / 1048576.0,
+           sample->heap / 1048576.0, sample->fds, sample->threads,
+           sample->p50_ns / 1e3, sample->p99_ns / 1e3, sample->max_ns / 1e3);
+  }
+}
+
+// Memory growth past the larger of MEMORY_SLACK and MEMORY_SHARE; returns
+// 1 if it drifted
+static int check_memory(const char *name, long base, long last) {
+  if (base < 0 || last < 0) {
+    printf("  %-10s n/a\n", name);
+    return 0;
+  }
+
+  long limit = (long)(base * MEMORY_SHARE);
+  if (limit < MEMORY_SLACK)
+    limit = MEMORY_SLACK;
+  int drifted = last - base > limit;
+  printf("  %-10s %+.2f MiB (limit %+.2f MiB)%s\n", name,
+         (last - base) / 1048576.0, limit / 1048576.0,
+         drifted ? "  DRIFT" : "");
+  return drifted;
+}
+
+static int check_count(const char *name, int base, int last) {
+  int drifted = base >= 0 && last > base;
+  printf("  %-10s %d -> %d%s\n", name, base, last, drifted ? "  DRIFT" : "");
+  return drifted;
+}
+
+static int check_frame_time(const char *name, long base, long last) {
+  long limit = (long)(base * FRAME_RATIO);
+  if (limit < base + FRAME_SLACK_NS)
+    limit = base + FRAME_SLACK_NS;
+  int drifted = last > limit;
+  printf("  %-10s %.1f -> %.1f us (limit %.1f us)%s\n", name, base / 1e3,
+         last / 1e3, limit / 1e3, drifted ? "  DRIFT" : "");
+  return drifted;
+}
+
+// Print the samples and compare the last one with the baseline: memory,
+// descriptors and threads as the warm-up left them, frame times of the
+// first interval after it. Returns the number of metrics that drifted.
+static int report(const sample_t *samples, int count, const char *source,
+                  double audio_s) {
+  long frames = 0;
+  for (int i = 0; i < count; i++)
+    frames += samples[i].frames;
+  double elapsed_s = count > 0 ? samples[count - 1].elapsed_s : 0.0;
+
+  printf("Soak test: %ld frames in %.1f s (%.0f fps), %.0f s of %s audio\n",
+         frames, elapsed_s, elapsed_s > 0.0 ? frames / elapsed_s : 0.0,
+         audio_s, source);
+  print_samples(samples, count);
+
+  if (count < 2) {
+    printf("Too short to measure drift: the first interval is warm-up\n");
+    return 0;
+  }
+
+  const sample_t *base = &samples[0];
+  const sample_t *frame_base = &samples[count > 2 ? 1 : 0];
+  const sample_t *last = &samples[count - 1];
+  int drifted = 0;
+
+  printf("Drift since warm-up:\n");
+  drifted += check_memory("rss", base->rss, last->rss);
+  drifted += check_memory("heap", base->heap, last->heap);
+  drifted += check_count("fds", base->fds, last->fds);
+  drifted += check_count("threads", base->threads, last->threads);
+  drifted += check_frame_time("frame p50", frame_base->p50_ns, last->p50_ns);
+  drifted += check_frame_time("frame p99", frame_base->p99_ns, last->p99_ns);
+  return drifted;
+}
+
+// Set up a soak test of the given length: with a journal, its sample
+// rate replaces config's. NULL on error.
+soak_t *soak_init(config_t *config, const char *journal_path, int seconds) {
+  if (seconds < 1) {
+    fprintf(stderr, "Soak duration must be at least a second\n");
+    return NULL;
+  }
+
+  soak_t *s = calloc(1, sizeof(soak_t));
+  if (!s) {
+    fprintf(stderr, "Failed to allocate the soak test\n");
+    return NULL;
+  }
+  s->sources = 1;
+  s->channels = SYNTH_CHANNELS;
+  s->sample_rate = config->sample_rate;
+  s->noise = 1;
+  if (config->sleep_timer > 0)
+    s->idle_ns = config->sleep_timer * 1000000L + IDLE_MARGIN_NS;
+
+  if (journal_path) {
+    int sample_rate;
+    int channels;
+    int sources;
+    s->journal_path = journal_path;
+    if (check_journal(s) != 0 ||
+        !(s->journal = journal_reader_open(journal_path, &sample_rate,
+                                           &channels, &sources))) {
+      soak_cleanup(s);
+      return NULL;
+    }
+    config->sample_rate = s->sample_rate;
+  } else {
+    s->block = malloc(SYNTH_BLOCK * SYNTH_CHANNELS * sizeof(float));
+    if (!s->block) {
+      fprintf(stderr, "Failed to allocate the soak test\n");
+      soak_cleanup(s);
+      return NULL;
+    }
+  }
+
+  // Whole intervals, ending on the last sample
+  s->interval_ns = (long)seconds * 1000000000L / SOAK_SAMPLES;
+  if (s->interval_ns < MIN_INTERVAL_NS)
+    s->interval_ns = MIN_INTERVAL_NS;
+  s->duration_ns =
+      (long)seconds * 1000000000L / s->interval_ns * s->interval_ns;
+  return s;
+}
+
+// Audio context the main loop captures from, fed at full speed by a
+// thread of its own; the soak clock starts here. NULL on error.
+audio_context_t *soak_audio(soak_t *s, const config_t *config) {
+  audio_context_t *audio = audio_init_feed(config, s->channels, s->sources);
+  if (!audio)
+    return NULL;
+
+  long now = now_ns();
+  s->next_idle = (long)SILENCE_EVERY_S * s->sample_rate;
+  s->start_ns = now;
+  s->next_sample_ns = now + s->interval_ns;
+  s->end_ns = now + s->duration_ns;
+
+  if (audio_start_feeder(audio, s->journal ? feed_journal : feed_synthetic,
+                         s) != 0) {
+    audio_cleanup(audio);
+    return NULL;
+  }
+  return audio;
+}
+
+// Whether soak_frame() at now takes a sample
+int soak_sample_due(const soak_t *s, long now) {
+  return now >= s->next_sample_ns && s->count < SOAK_SAMPLES;
+}
+
+// Account for one pass of the main loop that did work, taking frame_ns
+// and finishing at now; returns 1 once the run is over
+int soak_frame(soak_t *s, long frame_ns, long now) {
+  add_frame_time(s, frame_ns);
+  s->frames++;
+
+  // Intervals spent idle are folded into the next sample
+  if (now >= s->next_sample_ns) {
+    if (s->count < SOAK_SAMPLES)
+      take_sample(s, now);
+    while (s->next_sample_ns <= now)
+      s->next_sample_ns += s->interval_ns;
+  }
+  return now >= s->end_ns || __atomic_load_n(&s->failed, __ATOMIC_RELAXED);
+}
+
+// Sample what the last interval saw when the loop ends early (Ctrl-C),
+// before anything is torn down
+void soak_stop(soak_t *s, long now) {
+  if (s->frames > 0 && s->count < SOAK_SAMPLES + 1)
+    take_sample(s, now);
+}
+
+// Print the report; returns 0 if nothing drifted, 1 on drift or error
+int soak_report(const soak_t *s) {
+  int failed = __atomic_load_n(&s->failed, __ATOMIC_RELAXED);
+  int drifted = report(s->samples, s->count,
+                       s->journal_path ? "journal" : "synthetic",
+                       (double)s->fed / s->sample_rate);
+  if (drifted > 0)
+    printf("Soak test FAILED: %d metric%s drifted\n", drifted,
+           drifted == 1 ? "" : "s");
+  else if (!failed)
+    printf("Soak test passed\n");
+  return failed || drifted > 0 ? 1 : 0;
+}
+
+// Free the soak test; the audio context feeding from it must be gone
+void soak_cleanup(soak_t *s) {
+  if (!s)
+    return;
+
+  journal_reader_close(s->journal);
+  free(s->block);
+  free(s);
+}
@@ -0,0 +1,147 @@
+#define _GNU_SOURCE // syscall()
+#include "trace.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Spans kept (power of two, 32 bytes each); once the ring wraps the
+// newest spans win
+#define TRACE_CAPACITY (1 << 18)
+#define TRACE_MAX_THREADS 64
+
+typedef struct {
+  const char *name;
+  long start_ns;
+  long end_ns;
+  int tid;
+} trace_span_t;
+
+typedef struct {
+  int tid;
+  char name[32];
+} trace_thread_t;
+
+static FILE *trace_file;
+static const char *trace_path;
+static int enabled;
+static long origin_ns; // Timestamps are written relative to trace_open()
+
+static trace_span_t *spans;
+static unsigned long span_count; // Spans recorded (atomic)
+static trace_thread_t threads[TRACE_MAX_THREADS];
+static int thread_count; // Named threads (atomic)
+
+static __thread int thread_id;
+static __thread int thread_named;
+
+static int current_tid(void) {
+  if (!thread_id)
+    thread_id = (int)syscall(SYS_gettid);
+  return thread_id;
+}
+
+// Start tracing; the output file is created now so a bad path fails early
+int trace_open(const char *path) {
+  spans = malloc(sizeof(trace_span_t) * TRACE_CAPACITY);
+  if (!spans) {
+    fprintf(stderr, "Failed to allocate trace buffer\n");
+    return -1;
+  }
+  // Fault the ring in now rather than from the audio thread
+  memset(spans, 0, sizeof(trace_span_t) * TRACE_CAPACITY);
+
+  trace_file = fopen(path, "w");
+  if (!trace_file) {
+    fprintf(stderr, "Failed to open trace file: %s\n", path);
+    free(spans);
+    spans = NULL;
+    return -1;
+  }
+
+  trace_path = path;
+  origin_ns = now_ns();
+  enabled = 1;
+  trace_thread_name("main");
+  return 0;
+}
+
+// Label the calling thread in the trace (once per thread)
+void trace_thread_name(const char *name) {
+  if (!enabled || thread_named)
+    return;
+  thread_named = 1;
+
+  int index = __atomic_fetch_add(&thread_count, 1, __ATOMIC_RELAXED);
+  if (index >= TRACE_MAX_THREADS)
+    return;
+  threads[index].tid = current_tid();
+  snprintf(threads[index].name, sizeof(threads[index].name), "%s", name);
+}
+
+// Timestamp opening a span (0 while tracing is off)
+long trace_begin(void) { return enabled ? now_ns() : 0; }
+
+// Record a span from start_ns (trace_begin()) to now
+void trace_end(const char *name, long start_ns) {
+  if (!enabled || !start_ns)
+    return;
+
+  unsigned long index = __atomic_fetch_add(&span_count, 1, __ATOMIC_RELAXED);
+  trace_span_t *span = &spans[index & (TRACE_CAPACITY - 1)];
+  span->name = name;
+  span->start_ns = start_ns;
+  span->end_ns = now_ns();
+  span->tid = current_tid();
+}
+
+// Write the recorded spans as trace-event JSON. Call once every traced
+// thread has stopped.
+void trace_close(void) {
+  if (!trace_file)
+    return;
+  enabled = 0;
+
+  unsigned long count = span_count;
+  unsigned long first = count > TRACE_CAPACITY ? count - TRACE_CAPACITY : 0;
+  int named = thread_count < TRACE_MAX_THREADS ? thread_count
+                                               : TRACE_MAX_THREADS;
+  int pid = getpid();
+
+  fprintf(trace_file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  fprintf(trace_file,
+          "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+          "\"args\":{\"name\":\"audiovis\"}}",
+          pid);
+  for (int i = 0; i < named; i++)
+    fprintf(trace_file,
+            ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,"
+            "\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            pid, threads[i].tid, threads[i].name);
+
+  // Complete events, timestamps in microseconds
+  for (unsigned long i = first; i < count; i++) {
+    const trace_span_t *span = &spans[i & (TRACE_CAPACITY - 1)];
+    fprintf(trace_file,
+            ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+            "\"pid\":%d,\"tid\":%d}",
+            span->name, (span->start_ns - origin_ns) / 1e3,
+            (span->end_ns - span->start_ns) / 1e3, pid, span->tid);
+  }
+  fprintf(trace_file, "\n]}\n");
+
+  int failed = ferror(trace_file);
+  if (fclose(trace_file) != 0 || failed)
+    fprintf(stderr, "Failed to write trace file: %s\n", trace_path);
+  else if (first > 0)
+    printf("Wrote %lu spans to %s (%lu older spans dropped)\n",
+           count - first, trace_path, first);
+  else
+    printf("Wrote %lu spans to %s\n", count, trace_path);
+
+  trace_file = NULL;
+  free(spans);
+  spans = NULL;
+}
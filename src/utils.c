@@ -2,6 +2,7 @@
 #include <ctype.h>
 #include <math.h>
 #include <string.h>
+#include <time.h>
 
 // Trim leading and trailing whitespace from a string
 void trim_whitespace(char *str) {
@@ -45,3 +46,10 @@ float clamp(float value, float min, float max) {
     return max;
   return value;
 }
+
+// Monotonic clock in nanoseconds
+long now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}